@@ -16,7 +16,7 @@ EXECUTABLE_MODULES := main
 # Modules will have every .cpp file compiled and added to the link list
 # for any executable built. All header files in any module are seen by
 # every compile unit.
-MODULES := util physical virtual
+MODULES := util physical virtual policy prefetch sweep bench
 # To add a new file to existing module:
 #   Put a .cpp (and, if necessary, a .h) file in the subfolder
 #   with the module name. module.mk will pick up the new .cpp file
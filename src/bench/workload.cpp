@@ -0,0 +1,223 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <stdexcept>
+#include <system_error>
+
+#include "binaryTrace.h"
+#include "outputBuffer.h"
+
+// accesses generated at a time by write()
+static const size_t chunkSize = 1 << 16;
+
+bool WorkloadSettings::parse(int opt, const std::string& argument) {
+  switch (opt) {
+    case 'n':
+      accesses = std::stoull(argument, 0, 0);
+      return true;
+    case 'p':
+      pages = std::stoull(argument, 0, 0);
+      return true;
+    case 'w':
+      workingSet = std::stoull(argument, 0, 0);
+      return true;
+    case 'd':
+      stride = std::stoull(argument, 0, 0);
+      return true;
+    case 'z':
+      theta = std::stod(argument);
+      return true;
+    case 'l':
+      phaseLength = std::stoul(argument, 0, 0);
+      return true;
+    case 'W':
+      writeFraction = std::stod(argument);
+      return true;
+    case 'r':
+      seed = std::stoull(argument, 0, 0);
+      return true;
+  }
+  return false;
+}
+
+Workload::Workload(const WorkloadSettings& settings)
+    : _settings(settings), _state(settings.seed) {
+  if (settings.pages == 0)
+    throw std::invalid_argument("Workload: the footprint has no pages");
+  if (settings.geometry.pageWidth() < 64 &&
+      settings.pages > PageNumber(1) << settings.geometry.pageWidth())
+    throw std::invalid_argument(
+        "Workload: more pages than the address width holds");
+}
+
+bool Workload::next(std::vector<Access>& chunk, size_t n) {
+  chunk.clear();
+  while (chunk.size() < n && _generated < _settings.accesses) {
+    VirtualAddress a = address(_generated++);
+    chunk.push_back(Access{a, unit() < _settings.writeFraction});
+  }
+  return !chunk.empty();
+}
+
+void Workload::write(int fd, bool binary) {
+  OutputBuffer out(fd);
+  std::string encoded;
+  BinaryTraceEncoder encoder(encoded);
+  if (binary) {
+    BinaryTraceHeader header;
+    header.addressWidth = _settings.geometry.addressWidth;
+    header.offsetWidth = _settings.geometry.offsetWidth;
+    header.encode(encoded);
+  }
+  std::vector<Access> chunk;
+  while (next(chunk, chunkSize)) {
+    for (const Access& a : chunk) {
+      if (binary) {
+        encoder.access(a.write, a.address);
+        continue;
+      }
+      out.append(a.write ? "WRITE " : "READ  ");
+      out.hex(a.address, 8);
+      out.put('\n');
+    }
+    out.append(encoded);
+    encoded.clear();
+  }
+  if (out.pubsync() != 0)
+    throw std::system_error(errno, std::generic_category(), "writing a trace");
+}
+
+namespace {
+
+class Sequential : public Workload {
+ public:
+  explicit Sequential(const WorkloadSettings& settings)
+      : Workload(settings) {}
+
+ protected:
+  VirtualAddress address(unsigned long long i) override {
+    VirtualAddress lines = _settings.pages
+                           << (_settings.geometry.offsetWidth - 6);
+    return i % lines * 64;
+  }
+};
+
+class Strided : public Workload {
+ public:
+  explicit Strided(const WorkloadSettings& settings) : Workload(settings) {}
+
+ protected:
+  VirtualAddress address(unsigned long long) override {
+    // (i * stride) % pages, without overflow for large i
+    PageNumber p = _page;
+    _page = (_page + _settings.stride % _settings.pages) % _settings.pages;
+    return inPage(p);
+  }
+
+ private:
+  PageNumber _page{0};
+};
+
+class Uniform : public Workload {
+ public:
+  explicit Uniform(const WorkloadSettings& settings) : Workload(settings) {}
+
+ protected:
+  VirtualAddress address(unsigned long long) override {
+    return inPage(below(_settings.pages));
+  }
+};
+
+/**
+ * Zipf ranks by the method of Gray et al., "Quickly generating
+ * billion-record synthetic databases" (SIGMOD 1994): O(pages) to set up,
+ * O(1) per access.
+ */
+class Zipf : public Workload {
+ public:
+  explicit Zipf(const WorkloadSettings& settings) : Workload(settings) {
+    double theta = settings.theta;
+    if (!(theta > 0) || theta == 1)
+      throw std::invalid_argument("Workload: zipf needs theta > 0, not 1");
+    double n = settings.pages;
+    for (PageNumber i = 1; i <= settings.pages; i++)
+      _zetaN += 1 / std::pow(double(i), theta);
+    double zeta2 = 1 + 1 / std::pow(2.0, theta);
+    _alpha = 1 / (1 - theta);
+    _eta = (1 - std::pow(2 / n, 1 - theta)) / (1 - zeta2 / _zetaN);
+    _half = 1 + std::pow(0.5, theta);
+  }
+
+ protected:
+  VirtualAddress address(unsigned long long) override {
+    double u = unit();
+    double uz = u * _zetaN;
+    PageNumber rank;
+    if (uz < 1)
+      rank = 0;
+    else if (uz < _half)
+      rank = 1;
+    else
+      rank = _settings.pages * std::pow(_eta * u - _eta + 1, _alpha);
+    return inPage(std::min(rank, _settings.pages - 1));
+  }
+
+ private:
+  double _zetaN{0};
+  double _alpha;
+  double _eta;
+  double _half;
+};
+
+class Loop : public Workload {
+ public:
+  explicit Loop(const WorkloadSettings& settings) : Workload(settings) {
+    if (settings.workingSet == 0 || settings.workingSet > settings.pages)
+      throw std::invalid_argument(
+          "Workload: the working set must be 1 to the footprint in pages");
+  }
+
+ protected:
+  VirtualAddress address(unsigned long long i) override {
+    return inPage(i % _settings.workingSet);
+  }
+};
+
+class Phase : public Loop {
+ public:
+  explicit Phase(const WorkloadSettings& settings) : Loop(settings) {
+    if (settings.phaseLength == 0)
+      throw std::invalid_argument("Workload: a phase needs accesses");
+  }
+
+ protected:
+  VirtualAddress address(unsigned long long i) override {
+    if (i % _settings.phaseLength == 0)
+      _base = below(_settings.pages - _settings.workingSet + 1);
+    return inPage(_base + below(_settings.workingSet));
+  }
+
+ private:
+  PageNumber _base{0};
+};
+
+}  // namespace
+
+std::unique_ptr<Workload> Workload::make(const std::string& kind,
+                                         const WorkloadSettings& settings) {
+  if (kind == "seq") return std::make_unique<Sequential>(settings);
+  if (kind == "stride") return std::make_unique<Strided>(settings);
+  if (kind == "uniform") return std::make_unique<Uniform>(settings);
+  if (kind == "zipf") return std::make_unique<Zipf>(settings);
+  if (kind == "loop") return std::make_unique<Loop>(settings);
+  if (kind == "phase") return std::make_unique<Phase>(settings);
+  return nullptr;
+}
+
+const std::vector<std::string>& Workload::kinds() {
+  static const std::vector<std::string> names = {"seq",  "stride", "uniform",
+                                                 "zipf", "loop",   "phase"};
+  return names;
+}
@@ -0,0 +1,156 @@
+/**
+ * Workload class generates synthetic address traces for benchmarking.
+ *
+ * Each kind of workload stresses the simulator (and the replacement policies)
+ * differently:
+ *
+ *   seq      a sequential scan, a cache line at a time, over the footprint
+ *            and around again: many accesses per page, few faults
+ *   stride   one access per page, stepping a fixed number of pages (modulo
+ *            the footprint): no reuse within a pass
+ *   uniform  pages drawn uniformly from the footprint: no locality at all
+ *   zipf     pages drawn from a Zipf distribution over the footprint (page
+ *            0 the most popular): a skewed, cache friendly mix
+ *   loop     a cyclic scan over a working set of pages: LRU's worst case
+ *            once the working set is larger than RAM
+ *   phase    uniform accesses within a working set that moves to a random
+ *            place in the footprint every phase: working-set changes
+ *
+ * Workloads are generated a chunk at a time, so a trace of 10^9 accesses
+ * never has to be held in memory. The same settings (including the seed)
+ * always give the same trace.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "virtualMemoryTypes.h"
+
+/**
+ * The parameters of a workload; each kind uses those that apply to it.
+ */
+struct WorkloadSettings {
+  unsigned long long accesses{1000000};
+  PageNumber pages{16384};       // footprint
+  PageNumber workingSet{1536};   // loop and phase
+  PageNumber stride{17};         // stride, in pages
+  double theta{0.99};            // zipf skew, not 1
+  unsigned long phaseLength{100000};  // phase, in accesses
+  double writeFraction{0.25};
+  uint64_t seed{1};
+  Geometry geometry;  // page size and address width of the addresses
+
+  /**
+   * The getopt() letters of the command line options parse() takes, each
+   * with an argument: -n accesses, -p pages, -w workingSet, -d stride,
+   * -z theta, -l phaseLength, -W writeFraction and -r seed.
+   */
+  static constexpr const char* options = "n:p:w:d:z:l:W:r:";
+
+  /**
+   * Set the setting for command line option opt from its argument.
+   *
+   * @return false if opt is not one of options
+   * @throw std::invalid_argument, std::out_of_range on a bad number
+   */
+  bool parse(int opt, const std::string& argument);
+};
+
+/**
+ * One access of a trace.
+ */
+struct Access {
+  VirtualAddress address;
+  bool write;
+};
+
+class Workload {
+ public:
+  /**
+   * Build a workload of the given kind (see above).
+   *
+   * @return the new workload; nullptr if kind is not a known name
+   * @throw std::invalid_argument if the settings do not fit the kind (e.g.
+   * an empty footprint, or more pages than the address width holds)
+   */
+  static std::unique_ptr<Workload> make(const std::string& kind,
+                                        const WorkloadSettings& settings);
+
+  /**
+   * @return the names of every kind, in the order listed above
+   */
+  static const std::vector<std::string>& kinds();
+
+  virtual ~Workload() = default;
+
+  /**
+   * Replace the content of chunk with up to n more accesses.
+   *
+   * @return false, with chunk empty, if the trace has ended
+   */
+  bool next(std::vector<Access>& chunk, size_t n);
+
+  /**
+   * Write the rest of the trace to fd, as a text trace (READ/WRITE lines,
+   * as traceConvert -d writes them) or a binary one (see binaryTrace.h).
+   *
+   * @throw std::system_error if writing fails
+   */
+  void write(int fd, bool binary);
+
+  /**
+   * @return the number of accesses generated so far
+   */
+  unsigned long long generated() const { return _generated; }
+
+ protected:
+  explicit Workload(const WorkloadSettings& settings);
+
+  /**
+   * @return the address of access number i (from 0)
+   */
+  virtual VirtualAddress address(unsigned long long i) = 0;
+
+  /**
+   * @return the address of a random cache line in page p
+   */
+  VirtualAddress inPage(PageNumber p) {
+    return (p << _settings.geometry.offsetWidth) |
+           (random() & _settings.geometry.offsetMask() & ~VirtualAddress(63));
+  }
+
+  /**
+   * @return the next 64 random bits (splitmix64)
+   */
+  uint64_t random() {
+    uint64_t x = (_state += 0x9E3779B97F4A7C15ull);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  /**
+   * @return a random number in [0, n)
+   */
+  uint64_t below(uint64_t n) {
+    return (unsigned __int128)random() * n >> 64;
+  }
+
+  /**
+   * @return a random number in [0, 1)
+   */
+  double unit() { return (random() >> 11) * 0x1.0p-53; }
+
+  WorkloadSettings _settings;
+
+ private:
+  uint64_t _state;
+  unsigned long long _generated{0};
+};
+
+#endif /* WORKLOAD_H */
@@ -0,0 +1,145 @@
+/**
+ * Convert a text trace to the binary trace format, or back.
+ *
+ * Reads the trace on standard input and writes the converted trace to
+ * standard output. See binaryTrace.h for the format.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "binaryTrace.h"
+#include "string_util.h"
+#include "traceReader.h"
+#include "virtualMemoryTypes.h"
+
+using namespace std;
+
+// converted output is written in blocks of this size
+static const size_t blockSize = 1 << 20;
+
+/**
+ * Write out whatever is in the buffer and empty it.
+ */
+static void flushBlock(string& out) {
+  cout.write(out.data(), out.size());
+  out.clear();
+}
+
+/**
+ * Encode the text trace on fd into a binary trace on standard output.
+ *
+ * @return exit status for main
+ */
+int encode(int fd, const Geometry& geometry) {
+  string out;
+  out.reserve(blockSize + 64);
+  BinaryTraceHeader header;
+  header.addressWidth = geometry.addressWidth;
+  header.offsetWidth = geometry.offsetWidth;
+  header.encode(out);
+  BinaryTraceEncoder encoder(out);
+
+  LineReader input(fd);
+  string_view line;
+  TraceCommand cmd;
+  for (unsigned long number = 1; input.next(line); number++) {
+    try {
+      if (!parseCommand(line, cmd)) continue;
+    } catch (const exception&) {
+      cerr << "line " << number << ": bad address \"" << cmd.argument << "\""
+           << endl;
+      return 1;
+    }
+    if (cmd.op == TraceOp::READ || cmd.op == TraceOp::WRITE)
+      encoder.access(cmd.op == TraceOp::WRITE, cmd.address);
+    else
+      encoder.command(str_util::trim(line.substr(0, line.find('#'))));
+    if (out.size() >= blockSize) flushBlock(out);
+  }
+  flushBlock(out);
+  return 0;
+}
+
+/**
+ * Decode the binary trace on fd into a text trace on standard output.
+ *
+ * @return exit status for main
+ */
+int decode(int fd) {
+  TraceReader input(fd);
+  if (!input.binary()) {
+    cerr << "input is not a binary trace" << endl;
+    return 1;
+  }
+  string out;
+  out.reserve(blockSize + 64);
+  char address[32];
+  TraceCommand cmd;
+  while (input.next(cmd)) {
+    if (cmd.op == TraceOp::NONE) continue;
+    out.append(cmd.word);
+    if (cmd.op == TraceOp::READ || cmd.op == TraceOp::WRITE) {
+      out.append(cmd.op == TraceOp::READ ? "  " : " ");
+      snprintf(address, sizeof(address), "%08llx", cmd.address);
+      out.append(address);
+    } else if (!cmd.argument.empty()) {
+      out.push_back(' ');
+      out.append(cmd.argument);
+    }
+    out.push_back('\n');
+    if (out.size() >= blockSize) flushBlock(out);
+  }
+  flushBlock(out);
+  return 0;
+}
+
+/**
+ * Print the command line options on standard error.
+ */
+int usage(const char* program) {
+  cerr << "usage: " << program << " [-d] [-s pageSize] [-a addressBits]"
+       << endl;
+  return 1;
+}
+
+/**
+ * Trace converter.
+ *
+ * Options:
+ *   -d        decode: binary trace in, text trace out (default is to encode)
+ *   -s size   page size recorded in the binary header: 4K (default), ...
+ *   -a bits   address width recorded in the binary header (default 32)
+ */
+int main(int argc, char* argv[]) {
+  Geometry geometry;
+  bool toText = false;
+  try {
+    for (int opt; (opt = getopt(argc, argv, "ds:a:")) != -1;) {
+      if (opt == 'd') {
+        toText = true;
+      } else if (opt == 's' && geometry.parsePageSize(optarg)) {
+      } else if (opt == 'a') {
+        geometry.addressWidth = stoul(optarg);
+      } else {
+        return usage(argv[0]);
+      }
+    }
+  } catch (const exception&) {
+    return usage(argv[0]);
+  }
+  if (optind != argc || geometry.addressWidth > 64 ||
+      geometry.addressWidth <= geometry.offsetWidth)
+    return usage(argv[0]);
+
+  try {
+    return toText ? decode(fileno(stdin)) : encode(fileno(stdin), geometry);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,83 @@
+/**
+ * Generate a synthetic trace.
+ *
+ * Writes a trace of one of the workloads of workload.h to standard output,
+ * as a text trace or (with -b) a binary one, to feed vmSimulator.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "virtualMemoryTypes.h"
+#include "workload.h"
+
+using namespace std;
+
+/**
+ * Print the command line options on standard error.
+ */
+int usage(const char* program) {
+  cerr << "usage: " << program
+       << " [-n accesses] [-p pages] [-w workingSet] [-d stride] [-z theta]"
+          " [-l phaseLength] [-W writeFraction] [-r seed] [-s pageSize]"
+          " [-a addressBits] [-b] seq|stride|uniform|zipf|loop|phase"
+       << endl;
+  return 1;
+}
+
+/**
+ * Trace generator.
+ *
+ * Options:
+ *   -n accesses    length of the trace (default 1000000)
+ *   -p pages       footprint: the pages the trace may touch (default 16384)
+ *   -w pages       working set of loop and phase (default 1536)
+ *   -d pages       stride of stride (default 17)
+ *   -z theta       skew of zipf (default 0.99)
+ *   -l accesses    length of a phase of phase (default 100000)
+ *   -W fraction    fraction of the accesses that are writes (default 0.25)
+ *   -r seed        random seed (default 1)
+ *   -s size        page size: 4K (default), 16K, ...
+ *   -a bits        virtual address width (default 32)
+ *   -b             write a binary trace (default text)
+ */
+int main(int argc, char* argv[]) {
+  WorkloadSettings settings;
+  bool binary = false;
+  string options = WorkloadSettings::options + "s:a:b"s;
+  try {
+    for (int opt; (opt = getopt(argc, argv, options.c_str())) != -1;) {
+      if (settings.parse(opt, optarg ? optarg : "")) {
+      } else if (opt == 's' && settings.geometry.parsePageSize(optarg)) {
+      } else if (opt == 'a') {
+        settings.geometry.addressWidth = stoul(optarg);
+      } else if (opt == 'b') {
+        binary = true;
+      } else {
+        return usage(argv[0]);
+      }
+    }
+  } catch (const exception&) {
+    return usage(argv[0]);
+  }
+  if (optind + 1 != argc || settings.geometry.addressWidth > 64 ||
+      settings.geometry.addressWidth <= settings.geometry.offsetWidth)
+    return usage(argv[0]);
+
+  try {
+    unique_ptr<Workload> workload = Workload::make(argv[optind], settings);
+    if (!workload) {
+      cerr << "Unknown workload \"" << argv[optind] << "\"" << endl;
+      return 1;
+    }
+    workload->write(fileno(stdout), binary);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
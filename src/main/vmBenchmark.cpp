@@ -0,0 +1,267 @@
+/**
+ * Benchmark the simulator on synthetic workloads.
+ *
+ * Runs every combination of workload (see workload.h), replacement policy
+ * and frame count through its own RAM, page tables and MMU, and times the
+ * translation of every access. Each run is one CSV row on standard output
+ * and, with -o, appended to a results file, so runs of different builds can
+ * be compared to catch performance regressions:
+ *
+ *   time,label,workload,policy,frames,pages,accesses,faults,fault_rate,
+ *   seconds,accesses_per_second,ns_per_access,faults_per_second
+ *
+ * Only the simulation is timed. The workload is generated a chunk at a time
+ * between timed chunks, and OPT's index of the future is built before its
+ * run, from the same workload written to a temporary binary trace.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mmu.h"
+#include "nextUseIndex.h"
+#include "optPolicy.h"
+#include "processTable.h"
+#include "ram.h"
+#include "replacementPolicy.h"
+#include "string_util.h"
+#include "temporaryFile.h"
+#include "tlb.h"
+#include "traceReader.h"
+#include "virtualMemoryTypes.h"
+#include "workload.h"
+
+using namespace std;
+
+// accesses generated between timed chunks
+static const size_t chunkSize = 1 << 16;
+
+static const char* header =
+    "time,label,workload,policy,frames,pages,accesses,faults,fault_rate,"
+    "seconds,accesses_per_second,ns_per_access,faults_per_second";
+
+/**
+ * What every run of the benchmark has in common.
+ */
+struct Settings {
+  WorkloadSettings workload;
+  string layout{"x86-64"};
+  TLB::Config tlb;
+  string label;
+  string time;  // when the benchmark started, UTC
+};
+
+/**
+ * The measurements of one run.
+ */
+struct Result {
+  unsigned long accesses;
+  unsigned long faults;
+  double seconds;
+};
+
+/**
+ * Build OPT's index of the future accesses of a workload and install it.
+ */
+void indexFuture(const string& kind, const WorkloadSettings& settings) {
+  int fd = temporaryFile();
+  try {
+    Workload::make(kind, settings)->write(fd, true);
+    lseek(fd, 0, SEEK_SET);
+    TraceReader trace(fd);
+    OptPolicy::useIndex(make_shared<NextUseIndex>(trace, settings.geometry));
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+}
+
+/**
+ * Run a workload through a machine with the given policy and frames.
+ *
+ * @throw std::invalid_argument if the policy or the layout is unknown
+ */
+Result run(const string& kind, const string& policy, size_t frames,
+           const Settings& settings) {
+  const Geometry& geometry = settings.workload.geometry;
+  RAM ram(frames);
+  unique_ptr<ProcessTable> processes =
+      ProcessTable::make(settings.layout, geometry, settings.workload.pages);
+  if (!processes)
+    throw invalid_argument("Unknown page table layout \"" + settings.layout +
+                           "\"");
+  MMU mmu(ram, *processes, settings.tlb);
+  if (policy == "OPT") indexFuture(kind, settings.workload);
+  unique_ptr<ReplacementPolicy> selected = makePolicy(policy, ram);
+  if (!selected) throw invalid_argument("Unknown policy \"" + policy + "\"");
+  mmu.policy(std::move(selected));
+
+  unique_ptr<Workload> workload = Workload::make(kind, settings.workload);
+  vector<Access> chunk;
+  chrono::steady_clock::duration elapsed{0};
+  EventTime clock = 0;
+  while (workload->next(chunk, chunkSize)) {
+    auto start = chrono::steady_clock::now();
+    for (const Access& a : chunk)
+      mmu.access(getPage(a.address, geometry), ++clock, a.write);
+    elapsed += chrono::steady_clock::now() - start;
+  }
+  OptPolicy::useIndex(nullptr);
+  return Result{mmu.statistics().accesses(), mmu.statistics().faults,
+                chrono::duration<double>(elapsed).count()};
+}
+
+/**
+ * Format one CSV row of results.
+ */
+string row(const string& kind, const string& policy, size_t frames,
+           const Settings& settings, const Result& r) {
+  double seconds = r.seconds > 0 ? r.seconds : 1e-9;
+  ostringstream out;
+  out << settings.time << "," << settings.label << "," << kind << ","
+      << policy << "," << frames << "," << settings.workload.pages << ","
+      << r.accesses << "," << r.faults << "," << fixed << setprecision(6)
+      << (r.accesses ? double(r.faults) / r.accesses : 0.0) << ","
+      << r.seconds << "," << setprecision(0) << r.accesses / seconds << ","
+      << setprecision(2) << 1e9 * seconds / max(r.accesses, 1ul) << ","
+      << setprecision(0) << r.faults / seconds;
+  return out.str();
+}
+
+/**
+ * @return the current time, UTC, as YYYY-MM-DDTHH:MM:SSZ
+ */
+string now() {
+  time_t t = time(nullptr);
+  struct tm utc;
+  gmtime_r(&t, &utc);
+  char text[32];
+  strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  return text;
+}
+
+/**
+ * Print the command line options on standard error.
+ */
+int usage(const char* program) {
+  cerr << "usage: " << program
+       << " [-k workload,...] [-P POLICY,...] [-f frames,...]"
+          " [-n accesses] [-p pages] [-w workingSet] [-d stride] [-z theta]"
+          " [-l phaseLength] [-W writeFraction] [-r seed] [-s pageSize]"
+          " [-a addressBits] [-t flat|x86|x86-64] [-T tlb] [-o results.csv]"
+          " [-N label]"
+       << endl;
+  return 1;
+}
+
+/**
+ * Simulator benchmark.
+ *
+ * Options:
+ *   -k list        workloads (default all: seq,stride,uniform,zipf,loop,
+ *                  phase)
+ *   -P list        policies (default TIME,REF,CLOCK,ESC,WS,PFF,ARC,2Q,OPT)
+ *   -f list        frame counts (default 1024)
+ *   -n ... -r      the workload settings, as for traceGenerate
+ *   -s size        page size: 4K (default), 16K, ...
+ *   -a bits        virtual address width (default 32; 48 for x86-64)
+ *   -t layout      page table layout (default x86-64)
+ *   -T spec        TLB: entries[,ways[,lru|fifo|random[,flush|asid]]]
+ *   -o file        append the results to this CSV file (with a header line
+ *                  if it is empty)
+ *   -N label       label every result row, e.g. with the commit benchmarked
+ */
+int main(int argc, char* argv[]) {
+  Settings settings;
+  vector<string> kinds = Workload::kinds();
+  vector<string> policies = {"TIME", "REF", "CLOCK", "ESC", "WS",
+                             "PFF",  "ARC", "2Q",    "OPT"};
+  vector<size_t> frameCounts = {1024};
+  string resultsFile;
+  Geometry& geometry = settings.workload.geometry;
+  bool addressWidthSet = false;
+  string options = WorkloadSettings::options + "k:P:f:s:a:t:T:o:N:"s;
+  try {
+    for (int opt; (opt = getopt(argc, argv, options.c_str())) != -1;) {
+      if (settings.workload.parse(opt, optarg ? optarg : "")) {
+      } else if (opt == 'k') {
+        kinds = str_util::split(optarg);
+      } else if (opt == 'P') {
+        policies = str_util::split(optarg);
+      } else if (opt == 'f') {
+        frameCounts.clear();
+        for (const string& f : str_util::split(optarg))
+          frameCounts.push_back(stoul(f, 0, 0));
+      } else if (opt == 's' && geometry.parsePageSize(optarg)) {
+      } else if (opt == 'a') {
+        geometry.addressWidth = stoul(optarg);
+        addressWidthSet = true;
+      } else if (opt == 't') {
+        settings.layout = optarg;
+      } else if (opt == 'T' && settings.tlb.parse(optarg)) {
+      } else if (opt == 'o') {
+        resultsFile = optarg;
+      } else if (opt == 'N') {
+        settings.label = optarg;
+      } else {
+        return usage(argv[0]);
+      }
+    }
+  } catch (const exception&) {
+    return usage(argv[0]);
+  }
+  if (!addressWidthSet && settings.layout == "x86-64")
+    geometry.addressWidth = 48;
+  if (optind != argc || geometry.addressWidth > 64 ||
+      geometry.addressWidth <= geometry.offsetWidth ||
+      settings.workload.accesses >= neverUsed)
+    return usage(argv[0]);
+  for (size_t f : frameCounts)
+    if (f == 0 || f >= noSuchFrame) return usage(argv[0]);
+  settings.time = now();
+  try {
+    for (const string& kind : kinds)
+      if (!Workload::make(kind, settings.workload)) {
+        cerr << "Unknown workload \"" << kind << "\"" << endl;
+        return 1;
+      }
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  ofstream results;
+  if (!resultsFile.empty()) {
+    results.open(resultsFile, ios::app);
+    if (!results) {
+      cerr << "Cannot write " << resultsFile << endl;
+      return 1;
+    }
+    if (results.tellp() == 0) results << header << endl;
+  }
+  cout << header << endl;
+  try {
+    for (const string& kind : kinds)
+      for (const string& policy : policies)
+        for (size_t frames : frameCounts) {
+          string line = row(kind, policy, frames, settings,
+                            run(kind, policy, frames, settings));
+          cout << line << endl;
+          if (results.is_open()) results << line << endl;
+        }
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
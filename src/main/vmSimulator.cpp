@@ -15,127 +15,812 @@
 #include <unistd.h>
 
 #include <algorithm>
-#include <iomanip>
+#include <atomic>
+#include <bit>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "frame.h"
+#include "mmu.h"
+#include "nextUseIndex.h"
+#include "optPolicy.h"
+#include "outputBuffer.h"
+#include "pageFaultFrequencyPolicy.h"
 #include "pageTable.h"
+#include "prefetcher.h"
+#include "processTable.h"
 #include "ram.h"
+#include "replacementPolicy.h"
+#include "snapshot.h"
+#include "spscRing.h"
+#include "stackDistance.h"
 #include "string_util.h"
+#include "temporaryFile.h"
+#include "sweep.h"
+#include "tlb.h"
+#include "traceReader.h"
 #include "virtualMemoryTypes.h"
+#include "workingSetPolicy.h"
 
 using namespace std;
-using namespace str_util;
 
+// defaults for the -f and -p options
 constexpr int framesInRAM = 8;
 constexpr int pagesInProcess = 16;
-const string commentMarker = "#";
+
+// the options getopt accepts; usage() describes them
+constexpr char options[] = "f:p:s:a:t:T:L:r:I:H:A:W:F:qi:xC:S:P:j:mR:O";
+
+/**
+ * What the command loop reports besides the output of the commands, whether
+ * it runs pipelined, and the snapshot it resumes from.
+ */
+struct Reporting {
+  bool quiet{false};          // no per-access output; a summary at the end
+  unsigned long interval{0};  // events between interval reports; 0 for none
+  bool pipelined{false};      // parse, translate and print on three threads
+  string resume;  // a snapshot to restore before the first command, if any
+};
 
 /**
- * Print string to stdout iff stdin is connected to a keyboard.
+ * Print string to out iff stdin is connected to a keyboard.
  *
  * Uses istty() to detect whether stdin is redirected to a file.
- * Displays given string if it is not redirected.
+ * Displays given string if it is not redirected. The check is made once; the
+ * prompt is flushed, along with all the output before it, since out is
+ * otherwise only written when its buffer fills.
  *
+ * @param out the (buffered) output stream
  * @param displayString the string to print to stdout if input is not redirected
  * @return true
  */
-bool showOnlyOnScreen(const string& displayString) {
-  if (isatty(fileno(stdin))) cout << displayString;
+bool showOnlyOnScreen(ostream& out, const string& displayString) {
+  static const bool onScreen = isatty(fileno(stdin));
+  if (onScreen) out << displayString << flush;
   return true;
 }
 
 /**
- * Command-processor for simulating a virtual memory system.
+ * Print one per-access record: frame|offset* timestamp
+ */
+void printAccess(OutputBuffer& buffer, FrameNumber frame, Offset offset,
+                 bool pageFault, EventTime timestamp) {
+  buffer.hex(frame, 5);
+  buffer.put('|');
+  buffer.hex(offset, 3);
+  buffer.put(pageFault ? '*' : ' ');
+  buffer.put(' ');
+  buffer.dec(timestamp);
+  buffer.put('\n');
+}
+
+/**
+ * The output of the serial command loop: per-access records and text go
+ * straight into the OutputBuffer, in order.
+ */
+class DirectOutput {
+ public:
+  explicit DirectOutput(OutputBuffer& buffer)
+      : _buffer(buffer), _text(&buffer) {}
+
+  void access(FrameNumber frame, Offset offset, bool pageFault,
+              EventTime timestamp) {
+    printAccess(_buffer, frame, offset, pageFault, timestamp);
+  }
+
+  ostream& text() { return _text; }
+
+ private:
+  OutputBuffer& _buffer;
+  ostream _text;
+};
+
+/**
+ * The simulated machine as the command loop drives it: the event clock,
+ * the interval reports, and what each command does. Both the serial and the
+ * pipelined command loop run their commands through a Simulation, so they
+ * give the same output.
  *
- * Read standard input for commands: READ, WRITE, PAGES, FRAMES, TIME,
- * REF, CLEAR
+ * Templated on the geometry so that for the common page sizes (a
+ * FixedGeometry) the address split in the READ/WRITE path is constant folded;
+ * any other geometry runs the same code with a run time Geometry.
  */
-int main(int argc, char* argv[]) {
-  RAM ram(framesInRAM);
-  PageTable pageTable(pagesInProcess);
-  int eventClock = 0;
-  bool useTimeStamp = true;
-  bool trace = false;
-  vector<string> qWords{"quit", "Quit", "QUIT", "exit", "Exit", "EXIT"};
+template <typename G>
+class Simulation {
+ public:
+  Simulation(const G& geometry, MMU& mmu, const Reporting& reporting)
+      : _geometry(geometry),
+        _mmu(mmu),
+        _reporting(reporting),
+        _nextReport(reporting.interval) {}
 
-  string prompt = "> ";
+  /**
+   * Run one command. Output is the output's type: it takes each per-access
+   * record by access(frame, offset, pageFault, timestamp), unformatted, and
+   * every other line on the ostream text().
+   *
+   * A CHECKPOINT saves the trace position last given to position(), for a
+   * later run to resume from. A RESTORE replaces the state of the machine
+   * (and the event clock) with a snapshot's, and the trace is read on after
+   * it: the commands that follow run on the restored machine.
+   *
+   * @param op the command
+   * @param address the address of a READ/WRITE; the pid of
+   * PROCESS/FREE/FORK
+   * @param word the command word, the name of the policy for OTHER, the
+   * file for CHECKPOINT/RESTORE
+   * @param out where the output goes
+   * @return false if the command ends the trace (QUIT)
+   * @throw what the MMU throws, e.g. for a page past the end of the table,
+   * or what a snapshot throws; std::overflow_error for an access past the
+   * largest EventTime
+   */
+  template <typename Output>
+  bool execute(TraceOp op, VirtualAddress address, string_view word,
+               Output& out) {
+    switch (op) {
+      case TraceOp::READ:
+      case TraceOp::WRITE: {
+        if (_eventClock == std::numeric_limits<EventTime>::max())
+          throw std::overflow_error(
+              "more accesses than the event clock counts");
+        ++_eventClock;
+
+        PageNumber page = getPage(address, _geometry);
+        Offset offset = getOffset(address, _geometry);
+        Translation t = _mmu.access(page, _eventClock, op == TraceOp::WRITE);
+        if (!_reporting.quiet)
+          out.access(t.frame, offset, t.pageFault,
+                     _mmu.ram()[t.frame].timestamp());
+        if (_eventClock == _nextReport) {
+          printInterval(out.text(), _eventClock,
+                        _mmu.statistics() - _lastReport);
+          _lastReport = _mmu.statistics();
+          _nextReport += _reporting.interval;
+        }
+        break;
+      }
+      case TraceOp::PAGES:
+        out.text() << "PageTable------\n";
+        out.text() << _mmu.pageTable();
+        out.text() << "----------------\n";
+        break;
+      case TraceOp::FRAMES:
+        out.text() << "RAM--------------\n";
+        out.text() << _mmu.ram();
+        out.text() << "----------------\n";
+        break;
+      case TraceOp::CLEAR:
+        _mmu.clearReferenced();
+        break;
+      case TraceOp::TLB:
+        out.text() << _mmu.tlb();
+        break;
+      case TraceOp::PROCESS:
+        _mmu.switchTo(address);
+        break;
+      case TraceOp::FREE:
+        _mmu.free(address);
+        break;
+      case TraceOp::FORK:
+        _mmu.fork(address);
+        break;
+      case TraceOp::CHECKPOINT:
+        save(string(word));
+        break;
+      case TraceOp::RESTORE:
+        restore(string(word));
+        break;
+      case TraceOp::QUIT:
+        return false;
+      case TraceOp::NONE:  // ignore blank lines (and comment-only lines)
+        break;
+      case TraceOp::OTHER:
+        if (auto selected = makePolicy(string(word), _mmu.ram()))
+          _mmu.policy(std::move(selected));
+        else
+          out.text() << "Unknown command \"" << word << "\"\n";
+        break;
+    }
+    return true;
+  }
 
-  for (string line; showOnlyOnScreen(prompt), getline(cin, line);) {
-    // strip eoln-comments
-    string::size_type commentStart = line.find(commentMarker);
-    if (commentStart != string::npos) line = line.substr(0, commentStart);
+  /**
+   * Restore the snapshot to resume from, if there is one, and move input to
+   * the trace position saved with it.
+   */
+  void resume(TraceReader& input) {
+    if (_reporting.resume.empty()) return;
+    restore(_reporting.resume);
+    input.seek(_position);
+  }
 
-    // trim opening/closing whitespace
-    line = trim_left(trim_right(line));
+  /**
+   * Set the trace position the next CHECKPOINT saves: the one after it.
+   */
+  void position(const TracePosition& position) { _position = position; }
 
-    // ignore blank lines
-    if (line.empty()) continue;
+  /**
+   * Print what comes after the last command: the summary, if quiet.
+   */
+  void finish(ostream& out) {
+    if (_reporting.quiet)
+      printSummary(out, _mmu.statistics(), _mmu.policyPeriods(),
+                   _mmu.memoryUse());
+  }
 
-    // take apart the read line
-    stringstream readLine(line);
-    string cmd;
+ private:
+  /**
+   * Save the trace position, the event clock, the interval report state
+   * and the MMU to a snapshot at path.
+   */
+  void save(const string& path) const {
+    SnapshotWriter out(path);
+    out.put(_geometry.offsetWidth);
+    out.put(_position.offset);
+    out.put(_position.previous);
+    out.put(_eventClock);
+    out.put(_nextReport);
+    out.putObject(_lastReport);
+    out.put(_reporting.interval);
+    _mmu.save(out);
+    out.commit();
+  }
 
-    PageNumber page;
+  /**
+   * Replace the state with the snapshot at path.
+   */
+  void restore(const string& path) {
+    SnapshotReader in(path);
+    in.expect(_geometry.offsetWidth, "page size");
+    _position.offset = in.get();
+    _position.previous = in.get();
+    _eventClock = in.get();
+    if (_eventClock > std::numeric_limits<EventTime>::max())
+      throw std::runtime_error("bad snapshot");
+    _nextReport = in.get();
+    _lastReport = in.getObject<Statistics>();
+    in.expect(_reporting.interval, "report interval");
+    _mmu.restore(in);
+  }
+
+  G _geometry;
+  MMU& _mmu;
+  const Reporting& _reporting;
+  unsigned long _eventClock = 0;  // never past the largest EventTime
+  unsigned long _nextReport;
+  Statistics _lastReport;
+  TracePosition _position;  // of the trace after the last CHECKPOINT
+};
+
+/**
+ * @return the word Simulation::execute() takes for cmd
+ */
+string_view commandWord(const TraceCommand& cmd) {
+  bool snapshot = cmd.op == TraceOp::CHECKPOINT || cmd.op == TraceOp::RESTORE;
+  return snapshot ? cmd.argument : cmd.word;
+}
+
+/**
+ * The command loop: read the trace by line (or binary record) and process
+ * each command. Lines are read and parsed in place by the TraceReader, and
+ * all output is collected in an OutputBuffer that writes standard output a
+ * block at a time.
+ *
+ * @param geometry splits virtual addresses into page and offset
+ * @param input the trace to read
+ * @param mmu translates accesses; owns the policy and TLB
+ * @param reporting per-access output, summary and interval reports
+ * @return exit status for main
+ */
+template <typename G>
+int commandLoop(const G& geometry, TraceReader& input, MMU& mmu,
+                const Reporting& reporting) {
+  Simulation<G> simulation(geometry, mmu, reporting);
+  OutputBuffer buffer(fileno(stdout));
+  DirectOutput out(buffer);
+  string prompt = "> ";
+  TraceCommand cmd;
+
+  simulation.resume(input);
+  while (showOnlyOnScreen(out.text(), prompt) && input.next(cmd)) {
+    if (cmd.op == TraceOp::CHECKPOINT) simulation.position(input.position());
+    if (!simulation.execute(cmd.op, cmd.address, commandWord(cmd), out))
+      break;
+  }
+  simulation.finish(out.text());
+  return 0;
+}
+
+// commands per batch of the pipelined command loop, and batches in flight
+static const size_t batchSize = 1 << 12;
+static const size_t batchesInFlight = 8;
+
+/**
+ * A batch of commands on its way through the pipelined command loop. The
+ * parser fills in the commands, the translator runs them and records their
+ * output, and the output stage prints it; then the batch goes back to the
+ * parser to be filled again.
+ */
+struct Batch {
+  // a TraceCommand without its views of the reader's buffer
+  struct Command {
+    TraceOp op;
+    VirtualAddress address;  // for a command with a word (OTHER, CHECKPOINT,
+                             // RESTORE), its index in words
+  };
+
+  // a per-access record, and the end of the text printed before it
+  struct Access {
     FrameNumber frame;
     Offset offset;
-    VirtualAddress vaddress;
-
-    readLine >> cmd;
-    if ((cmd == "READ") || (cmd == "WRITE")) {
-      // Did this access cause a page fault interrupt?
-      bool pageFault = false;  // not yet
-      string vaddressString;
-      readLine >> vaddressString;
-
-      vaddress = stoi(vaddressString, 0, 16);
-      ++eventClock;
-
-      page = getPage(vaddress);
-      if (trace)
-        cout << "Page is: " << page << "; Original string: " << vaddressString
-             << endl;
-
-      offset = getOffset(vaddress);
-      frame = pageTable.lookup(page);
-      if (frame == noSuchFrame) {
-        // page is not loaded in a frame (page fault interrupt)
-        frame = ram.load(page, pageTable, useTimeStamp);
-        pageFault = true;
+    bool pageFault;
+    EventTime timestamp;
+    size_t textEnd;
+  };
+
+  vector<Command> commands;
+  vector<string> words;
+  vector<TracePosition> positions;  // of the trace after each word's command
+  bool last{false};  // the parser's final batch
+
+  vector<Access> accesses;
+  string text;  // the output other than the per-access records
+};
+
+/**
+ * The output of the translator stage: per-access records are kept
+ * unformatted in the batch, and text is collected along with where each
+ * record falls in it.
+ */
+class BatchOutput {
+ public:
+  void start(Batch& batch) {
+    _batch = &batch;
+    _batch->accesses.clear();
+  }
+
+  void access(FrameNumber frame, Offset offset, bool pageFault,
+              EventTime timestamp) {
+    _batch->accesses.push_back(Batch::Access{frame, offset, pageFault,
+                                             timestamp, _text.view().size()});
+  }
+
+  ostream& text() { return _text; }
+
+  void finish() {
+    _batch->text = std::move(_text).str();
+    _text.str("");
+  }
+
+ private:
+  Batch* _batch{nullptr};
+  ostringstream _text;
+};
+
+/**
+ * The pipelined command loop: the same commands and output as commandLoop,
+ * but the trace is parsed on one thread, the commands are run through the
+ * MMU on a second, and the output is formatted and written on the calling
+ * thread. Commands go from stage to stage in batches, through single
+ * producer, single consumer rings that also return the printed batches to
+ * the parser, so each stage works on one batch while the next stage works
+ * on the one before it. Every stage takes the batches in trace order, so
+ * the output is the same as the serial loop's.
+ *
+ * An error stops the run as it would the serial loop: the output of the
+ * commands before it is printed, then the error is thrown.
+ *
+ * @param geometry splits virtual addresses into page and offset
+ * @param input the trace to read
+ * @param mmu translates accesses; owns the policy and TLB
+ * @param reporting per-access output, summary and interval reports
+ * @return exit status for main
+ */
+template <typename G>
+int pipelinedLoop(const G& geometry, TraceReader& input, MMU& mmu,
+                  const Reporting& reporting) {
+  Simulation<G> simulation(geometry, mmu, reporting);
+  vector<Batch> batches(batchesInFlight);
+  SpscRing<Batch*> parsed(batchesInFlight);
+  SpscRing<Batch*> translated(batchesInFlight);
+  SpscRing<Batch*> printed(batchesInFlight);
+  for (Batch& batch : batches) printed.push(&batch);
+  exception_ptr parseError;
+  exception_ptr translateError;
+  atomic<bool> failed{false};  // the translator stopped: parse no further
+
+  simulation.resume(input);
+  thread parser([&] {
+    TraceCommand cmd;
+    for (bool more = true; more;) {
+      Batch* batch = printed.pop();
+      batch->commands.clear();
+      batch->words.clear();
+      batch->positions.clear();
+      try {
+        while (batch->commands.size() < batchSize && input.next(cmd)) {
+          if (cmd.op == TraceOp::NONE) continue;
+          VirtualAddress address = cmd.address;
+          if (cmd.op == TraceOp::OTHER || cmd.op == TraceOp::CHECKPOINT ||
+              cmd.op == TraceOp::RESTORE) {
+            address = batch->words.size();
+            batch->words.emplace_back(commandWord(cmd));
+            batch->positions.push_back(input.position());
+          }
+          batch->commands.push_back(Batch::Command{cmd.op, address});
+          if (cmd.op == TraceOp::QUIT) break;
+        }
+        more = batch->commands.size() == batchSize &&
+               batch->commands.back().op != TraceOp::QUIT;
+      } catch (...) {
+        parseError = current_exception();
+        more = false;
       }
+      if (failed.load(memory_order_relaxed)) more = false;
+      batch->last = !more;
+      parsed.push(batch);
+    }
+  });
 
-      // frame is frame of this address
-      ram[frame].timestamp(eventClock);
-      pageTable[page].referenced(true);
-      cout << hex << setw(5) << setfill('0') << frame << '|' << hex << setw(3)
-           << setfill('0') << offset << (pageFault ? "*" : " ") << dec << " "
-           << ram[frame].timestamp() << endl;
-
-    } else if (cmd == "PAGES") {
-      cout << "PageTable------" << endl;
-      cout << pageTable;
-      cout << "----------------" << endl;
-    } else if (cmd == "FRAMES") {
-      cout << "RAM--------------" << endl;
-      cout << ram;
-      cout << "----------------" << endl;
-
-    } else if (cmd == "TIME") {
-      useTimeStamp = true;
-
-    } else if (cmd == "REF") {
-      useTimeStamp = false;
-
-    } else if (cmd == "CLEAR") {
-      pageTable.clearReferenced();
-
-    } else if (std::find(qWords.begin(), qWords.end(), cmd) != qWords.end())
-      return 0;
-    else {
-      cout << "Unknown command \"" << cmd << "\"" << endl;
+  thread translator([&] {
+    BatchOutput out;
+    for (bool last = false; !last;) {
+      Batch* batch = parsed.pop();
+      last = batch->last;
+      out.start(*batch);
+      try {
+        for (const Batch::Command& c : batch->commands) {
+          if (translateError) break;
+          string_view word;
+          if (c.op == TraceOp::OTHER || c.op == TraceOp::CHECKPOINT ||
+              c.op == TraceOp::RESTORE)
+            word = batch->words[c.address];
+          if (c.op == TraceOp::CHECKPOINT)
+            simulation.position(batch->positions[c.address]);
+          if (!simulation.execute(c.op, c.address, word, out)) break;
+        }
+      } catch (...) {
+        translateError = current_exception();
+        failed.store(true, memory_order_relaxed);
+      }
+      out.finish();
+      translated.push(batch);
     }
+  });
+
+  OutputBuffer buffer(fileno(stdout));
+  for (bool last = false; !last;) {
+    Batch* batch = translated.pop();
+    last = batch->last;
+    string_view text = batch->text;
+    size_t printedText = 0;
+    for (const Batch::Access& a : batch->accesses) {
+      buffer.append(text.substr(printedText, a.textEnd - printedText));
+      printedText = a.textEnd;
+      printAccess(buffer, a.frame, a.offset, a.pageFault, a.timestamp);
+    }
+    buffer.append(text.substr(printedText));
+    if (!last) printed.push(batch);
   }
+  parser.join();
+  translator.join();
+  // an error in the translator came before the end of what was parsed
+  if (translateError) rethrow_exception(translateError);
+  if (parseError) rethrow_exception(parseError);
+  ostream out(&buffer);
+  simulation.finish(out);
   return 0;
 }
+
+/**
+ * Run the pipelined command loop if asked to and the trace is not typed at
+ * a terminal (where each command's output must follow it at once), else the
+ * serial one.
+ */
+template <typename G>
+int runCommandLoop(const G& geometry, TraceReader& input, MMU& mmu,
+                   const Reporting& reporting) {
+  static const bool onScreen = isatty(fileno(stdin));
+  if (reporting.pipelined && !onScreen)
+    return pipelinedLoop(geometry, input, mmu, reporting);
+  return commandLoop(geometry, input, mmu, reporting);
+}
+
+/**
+ * Run the command loop with a FixedGeometry if the page size is one of the
+ * common ones, else with the run time geometry.
+ */
+template <unsigned AddressWidth>
+int commandLoopForPageSize(const Geometry& geometry, TraceReader& input,
+                           MMU& mmu, const Reporting& reporting) {
+  switch (geometry.offsetWidth) {
+    case 12:  // 4K
+      return runCommandLoop(FixedGeometry<12, AddressWidth>(), input,
+                            mmu, reporting);
+    case 14:  // 16K
+      return runCommandLoop(FixedGeometry<14, AddressWidth>(), input,
+                            mmu, reporting);
+    case 16:  // 64K
+      return runCommandLoop(FixedGeometry<16, AddressWidth>(), input,
+                            mmu, reporting);
+    case 21:  // 2M
+      return runCommandLoop(FixedGeometry<21, AddressWidth>(), input,
+                            mmu, reporting);
+  }
+  return runCommandLoop(geometry, input, mmu, reporting);
+}
+
+/**
+ * Print the command line options on standard error.
+ */
+int usage(const char* program) {
+  cerr << "usage: " << program
+       << " [-f frames] [-p pages] [-s pageSize] [-a addressBits]"
+          " [-t flat|x86|x86-64]"
+          " [-T entries[,ways[,lru|fifo|random[,flush|asid]]]]"
+          " [-L hit,walk] [-r global|local] [-I in,out] [-H hugePageSize]"
+          " [-A seq|stride|markov[,depth]]"
+          " [-W window] [-F interval] [-O] [-q] [-i events] [-x]"
+          " [-C snapshot]"
+          " [-S frames,...] [-P POLICY,...] [-j threads] [-m [-R rate]]"
+       << endl;
+  return 1;
+}
+
+/**
+ * Command-processor for simulating a virtual memory system.
+ *
+ * Read standard input for commands: READ, WRITE, PAGES, FRAMES, CLEAR, TLB,
+ * PROCESS, FREE, FORK, CHECKPOINT, RESTORE, and the name of any registered
+ * ReplacementPolicy (TIME, REF, CLOCK, ..., and OPT with -O) to select it.
+ * Standard input is either a text trace or a binary trace (made by
+ * traceConvert); the page size and address width of a binary trace are
+ * taken from its header unless -s or -a is given.
+ *
+ * Options:
+ *   -f frames  number of frames in RAM (default 8)
+ *   -p pages   number of pages in a flat page table (default 16)
+ *   -s size    page size: 4K (default), 16K, 64K, 2M, ...
+ *   -a bits    virtual address width (default 32; 48 for x86-64)
+ *   -t layout  page table layout: flat (default), x86 (10 bits per level)
+ *              or x86-64 (9 bits per level)
+ *   -T spec    TLB: entries[,ways[,lru|fifo|random[,flush|asid]]]
+ *   -L spec    TLB latency in cycles: hit,walk (walk is per table level)
+ *   -r scope   replacement scope: global (default) or local to the process
+ *   -I spec    paging I/O cost in cycles: in,out (out is for dirty pages)
+ *   -H size    huge pages of this size (2M, 1G, 4M with x86, ...) along with
+ *              the base pages of -s; needs a radix layout
+ *   -A spec    prefetch: kind[,depth] where kind is seq (read-ahead), stride
+ *              or markov, and depth the most pages loaded ahead of one
+ *              access (16)
+ *   -W window  WS policy: events a page stays in the working set (1000)
+ *   -F events  PFF policy: a process whose faults are further apart than
+ *              this gives back the pages it has not used since (100)
+ *   -O         index the trace's future accesses in a first pass so the OPT
+ *              policy can be selected (implied by OPT in a -P list)
+ *   -q         quiet: no per-access output; print a summary at the end
+ *   -i events  print a statistics line every so many events
+ *   -x         pipelined: parse the trace, run the MMU and format the output
+ *              on three threads (the same output; ignored at a terminal)
+ *   -C file    resume from a snapshot taken by CHECKPOINT: restore it and
+ *              go on from the trace position saved with it (the same
+ *              options and trace as the run that took it)
+ *   -S list    sweep: simulate each of these frame counts (default -f)
+ *   -P list    sweep: with each of these policies (default TIME)
+ *   -j threads sweep: worker threads (default one per hardware thread)
+ *
+ * With -S or -P the trace is read once and run through every combination of
+ * frame count and policy, each on its own machine; only a table of their
+ * statistics is printed, and policy commands in the trace are ignored.
+ *
+ *   -m         miss-ratio curve: compute the TIME (LRU) faults for every
+ *              frame count from 1 to -p in one pass, from stack distances
+ *   -R rate    with -m: sample this fraction of the pages (e.g. 0.01)
+ */
+int main(int argc, char* argv[]) {
+  string layout = "flat";
+  Geometry geometry;
+  bool pageSizeSet = false;
+  bool addressWidthSet = false;
+  unsigned long frames = framesInRAM;
+  unsigned long pages = pagesInProcess;
+  TLB::Config tlbConfig;
+  Reporting reporting;
+  bool local = false;
+  IOCost io;
+  unsigned hugeWidth = 0;  // offset width of a huge page; 0 for none
+  vector<unsigned long> sweepFrames;
+  vector<string> sweepPolicies;
+  unsigned sweepThreads = 0;
+  string prefetcher;
+  unsigned prefetchDepth = 16;
+  bool optIndex = false;
+  bool missRatio = false;
+  double sampleRate = 1.0;
+  try {
+    for (int opt; (opt = getopt(argc, argv, options)) != -1;) {
+      if (opt == 'f') {
+        frames = stoul(optarg, 0, 0);
+      } else if (opt == 'p') {
+        pages = stoul(optarg, 0, 0);
+      } else if (opt == 's' && geometry.parsePageSize(optarg)) {
+        pageSizeSet = true;
+      } else if (opt == 'a') {
+        geometry.addressWidth = stoul(optarg);
+        addressWidthSet = true;
+      } else if (opt == 't') {
+        layout = optarg;
+      } else if (opt == 'T' && tlbConfig.parse(optarg)) {
+      } else if (opt == 'L' && tlbConfig.parseLatency(optarg)) {
+      } else if (opt == 'r' && (optarg == "global"s || optarg == "local"s)) {
+        local = (optarg == "local"s);
+      } else if (opt == 'I' && io.parse(optarg)) {
+      } else if (opt == 'H') {
+        Geometry huge;
+        if (!huge.parsePageSize(optarg)) return usage(argv[0]);
+        hugeWidth = huge.offsetWidth;
+      } else if (opt == 'A') {
+        vector<string> spec = str_util::split(optarg);
+        const vector<string>& kinds = Prefetcher::kinds();
+        if (spec.empty() || spec.size() > 2 ||
+            find(kinds.begin(), kinds.end(), spec[0]) == kinds.end())
+          return usage(argv[0]);
+        prefetcher = spec[0];
+        if (spec.size() == 2) prefetchDepth = stoul(spec[1], 0, 0);
+      } else if (opt == 'q') {
+        reporting.quiet = true;
+      } else if (opt == 'i') {
+        reporting.interval = stoul(optarg, 0, 0);
+      } else if (opt == 'x') {
+        reporting.pipelined = true;
+      } else if (opt == 'C') {
+        reporting.resume = optarg;
+      } else if (opt == 'S') {
+        for (const string& f : str_util::split(optarg))
+          sweepFrames.push_back(stoul(f, 0, 0));
+      } else if (opt == 'P') {
+        for (const string& p : str_util::split(optarg))
+          sweepPolicies.push_back(p);
+      } else if (opt == 'j') {
+        sweepThreads = stoul(optarg, 0, 0);
+      } else if (opt == 'W') {
+        WorkingSetPolicy::window(stoul(optarg, 0, 0));
+      } else if (opt == 'F') {
+        PageFaultFrequencyPolicy::threshold(stoul(optarg, 0, 0));
+      } else if (opt == 'O') {
+        optIndex = true;
+      } else if (opt == 'm') {
+        missRatio = true;
+      } else if (opt == 'R') {
+        sampleRate = stod(optarg);
+      } else {
+        return usage(argv[0]);
+      }
+    }
+  } catch (const exception&) {
+    return usage(argv[0]);
+  }
+
+  if (find(sweepPolicies.begin(), sweepPolicies.end(), "OPT") !=
+      sweepPolicies.end())
+    optIndex = true;
+
+  // OPT reads the trace twice: once for its index, once to run it
+  int traceFd = fileno(stdin);
+  std::unique_ptr<TraceReader> trace;
+  try {
+    if (optIndex) traceFd = rewindableInput(traceFd);
+    trace = std::make_unique<TraceReader>(traceFd);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  if (trace->binary()) {
+    if (!pageSizeSet) geometry.offsetWidth = trace->header().offsetWidth;
+    if (!addressWidthSet)
+      geometry.addressWidth = trace->header().addressWidth;
+    addressWidthSet = true;
+  }
+  if (!addressWidthSet && layout == "x86-64") geometry.addressWidth = 48;
+  // a Frame holds a page number in the pageBits of its packed word
+  if (frames == 0 || frames >= noSuchFrame || pages == 0 ||
+      geometry.addressWidth > 64 ||
+      geometry.addressWidth <= geometry.offsetWidth ||
+      geometry.pageWidth() > unsigned(std::bit_width(Frame::pageBits)) ||
+      pages > 1ull << geometry.pageWidth() ||
+      (hugeWidth != 0 && hugeWidth <= geometry.offsetWidth))
+    return usage(argv[0]);
+  unsigned hugeShift = hugeWidth ? hugeWidth - geometry.offsetWidth : 0;
+
+  if (optIndex) {
+    try {
+      OptPolicy::useIndex(make_shared<NextUseIndex>(*trace, geometry));
+      lseek(traceFd, 0, SEEK_SET);
+      trace = std::make_unique<TraceReader>(traceFd);
+    } catch (const exception& e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+  }
+  TraceReader& input = *trace;
+
+  if (missRatio) {
+    try {
+      StackDistance analysis(geometry, sampleRate);
+      analysis.run(input);
+      printMissRatioCurve(cout, analysis, pages);
+    } catch (const exception& e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (!sweepFrames.empty() || !sweepPolicies.empty()) {
+    if (sweepFrames.empty()) sweepFrames.push_back(frames);
+    if (sweepPolicies.empty()) sweepPolicies.push_back("TIME");
+    vector<SweepConfiguration> configurations;
+    for (unsigned long f : sweepFrames) {
+      if (f == 0 || f >= noSuchFrame) return usage(argv[0]);
+      for (const string& p : sweepPolicies) configurations.push_back({f, p});
+    }
+    SweepSettings settings{layout, geometry, pages,     tlbConfig,
+                           local,  io,       hugeShift, sweepThreads,
+                           prefetcher, prefetchDepth};
+    try {
+      Sweep sweep(configurations, settings);
+      sweep.run(input);
+      cout << sweep;
+    } catch (const exception& e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  std::unique_ptr<RAM> ram;
+  std::unique_ptr<ProcessTable> processes;
+  try {
+    ram = std::make_unique<RAM>(frames);
+    processes = ProcessTable::make(layout, geometry, pages);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  if (!processes) {
+    cerr << "Unknown page table layout \"" << layout << "\"" << endl;
+    return 1;
+  }
+  MMU mmu(*ram, *processes, tlbConfig, local, io);
+  if (hugeShift != 0 && !mmu.hugePages(hugeShift)) {
+    cerr << "No level of the \"" << layout
+         << "\" page table maps huge pages of that size" << endl;
+    return 1;
+  }
+  if (!prefetcher.empty())
+    mmu.prefetcher(Prefetcher::make(prefetcher, prefetchDepth));
+
+  // a bad address or binary record ends the run; the output before it is
+  // flushed as the command loop unwinds
+  try {
+    switch (geometry.addressWidth) {
+      case 32:
+        return commandLoopForPageSize<32>(geometry, input, mmu, reporting);
+      case 48:
+        return commandLoopForPageSize<48>(geometry, input, mmu, reporting);
+    }
+    return runCommandLoop(geometry, input, mmu, reporting);
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
@@ -2,8 +2,13 @@
  * The Frame class implements a frame, which represents a chunk of RAM.
  *
  * It stores whether it is being used (_free), the PageNumber which  corresponds
- * to it in PageTable and the time it was created/accessed
+ * to it in PageTable, the process that page belongs to and the time it was
+ * created/accessed
  *
+ * The free flag shares a 64-bit word with the page number (bit 63 is the
+ * free flag, bits 0..51 the page), so a Frame is 16 bytes. Bit 62 marks a
+ * page loaded by a prefetch and not used since. Bits 52..61 count the PTE
+ * that map the frame: more than one once processes share it after a FORK.
  */
 
 #ifndef FRAME_H
@@ -56,6 +61,22 @@ class Frame {
    */
   EventTime timestamp(EventTime newReference);
 
+  /**
+   * Get the process owning the page in the frame.
+   *
+   * @return ProcessId of the page's process if frame is not free;
+   * noSuchProcess otherwise.
+   */
+  ProcessId process() const;
+
+  /**
+   * Set the process owning the page in the frame.
+   *
+   * @param newProcess new value for the process
+   * @return ProcessId in frame after it is set
+   */
+  ProcessId process(ProcessId newProcess);
+
   /**
    * Is the frame currently free?
    *
@@ -71,12 +92,116 @@ class Frame {
    */
   bool free(bool newFree);
 
+  /**
+   * Was the page in the frame prefetched, and not used since?
+   *
+   * @return true if so; false otherwise
+   */
+  bool prefetched() const;
+
+  /**
+   * Set the prefetched bit in the frame.
+   *
+   * @param newPrefetched the new value for the prefetched bit
+   * @return prefetched bit after it is set
+   */
+  bool prefetched(bool newPrefetched);
+
+  /**
+   * Get the number of PTE mapping the frame (the head of a huge page's
+   * run); RAM keeps the PTE themselves.
+   *
+   * @return the count, which saturates at maxMappings; 0 if unmapped
+   */
+  unsigned mappings() const;
+
+  /**
+   * Set the number of PTE mapping the frame.
+   *
+   * @param newMappings the new count; more than maxMappings counts as that
+   * @return count after it is set
+   */
+  unsigned mappings(unsigned newMappings);
+
+  // bits of the packed word
+  static constexpr unsigned long long freeBit = 0x8000000000000000;
+  static constexpr unsigned long long prefetchedBit = 0x4000000000000000;
+  static constexpr unsigned long long mappingBits = 0x3FF0000000000000;
+  static constexpr unsigned long long pageBits = 0x000FFFFFFFFFFFFF;
+  static constexpr unsigned mappingShift = 52;
+  static constexpr unsigned maxMappings = mappingBits >> mappingShift;
+
  private:
-  bool _free{true};
-  PageNumber _page{noSuchPage};
+  unsigned long long _word{freeBit | pageBits};
   EventTime _reference{0};
+  ProcessId _process{0};
 };
 
+static_assert(sizeof(Frame) == 16, "Frame must pack into 16 bytes");
+
+// The accessors are on the path of every access; defined here so every
+// module can inline them.
+
+inline Frame::Frame() {}
+
+inline Frame::Frame(bool free, PageNumber pn) {
+  this->free(free);
+  page(pn);
+}
+
+inline PageNumber Frame::page() const {
+  if (free()) return noSuchPage;
+  return _word & pageBits;
+}
+
+inline PageNumber Frame::page(PageNumber newPage) {
+  _word = (_word & ~pageBits) | (newPage & pageBits);
+  return newPage & pageBits;
+}
+
+inline EventTime Frame::timestamp() const {
+  if (free()) return 0;
+  return _reference;
+}
+
+inline EventTime Frame::timestamp(EventTime newReference) {
+  return _reference = newReference;
+}
+
+inline ProcessId Frame::process() const {
+  if (free()) return noSuchProcess;
+  return _process;
+}
+
+inline ProcessId Frame::process(ProcessId newProcess) {
+  return _process = newProcess;
+}
+
+inline bool Frame::free() const { return _word & freeBit; }
+
+inline bool Frame::free(bool newFree) {
+  _word = newFree ? (_word | freeBit) : (_word & ~freeBit);
+  return newFree;
+}
+
+inline bool Frame::prefetched() const { return _word & prefetchedBit; }
+
+inline bool Frame::prefetched(bool newPrefetched) {
+  _word = newPrefetched ? (_word | prefetchedBit) : (_word & ~prefetchedBit);
+  return newPrefetched;
+}
+
+inline unsigned Frame::mappings() const {
+  return (_word & mappingBits) >> mappingShift;
+}
+
+inline unsigned Frame::mappings(unsigned newMappings) {
+  if (newMappings > maxMappings) newMappings = maxMappings;
+  _word = (_word & ~mappingBits) |
+          (static_cast<unsigned long long>(newMappings) << mappingShift);
+  return newMappings;
+}
+
 /**
  * Output operator for one PTE
  *
@@ -85,9 +210,11 @@ class Frame {
  *   |       free|
  * else
  *   |fffff|ttttt|
+ * followed by " pid" if the page belongs to a process other than 0
  *
  * Where fffff is the loaded page number in hex
  * Where ttttt is the decimal time stamp in space padded 5 characters
+ * Where pid is the decimal process id
  * Note: This format does NOT include an end of line.
  *
  * @param out target output stream to print on
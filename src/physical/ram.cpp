@@ -1,38 +1,208 @@
 #include "ram.h"
 
-RAM::RAM(const size_t n) { resize(n); }
+#include <bit>
+#include <span>
+#include <stdexcept>
+
+#include "processTable.h"
+#include "snapshot.h"
+
+RAM::RAM(const size_t n) : _mapping(n, nullptr), _freeBits((n + 63) / 64) {
+  resize(n);
+  for (size_t f = 0; f < n; f++) _freeBits[f / 64] |= uint64_t(1) << f % 64;
+}
+
+void RAM::take(FrameNumber f) {
+  (*this)[f].free(false);
+  _freeBits[f / 64] &= ~(uint64_t(1) << f % 64);
+}
+
+void RAM::give(FrameNumber f) {
+  (*this)[f].free(true);
+  _freeBits[f / 64] |= uint64_t(1) << f % 64;
+  _firstFree = std::min<size_t>(_firstFree, f / 64);
+}
 
 FrameNumber RAM::findFree() {
-  for (size_t i = 0; i < (*this).size(); i++)
-    if ((*this)[i].free()) return i;
+  for (; _firstFree < _freeBits.size(); _firstFree++)
+    if (uint64_t word = _freeBits[_firstFree])
+      return _firstFree * 64 + std::countr_zero(word);
+  return noSuchFrame;
+}
+
+FrameNumber RAM::findFreeRun() const {
+  if (_hugeRun == 0 || size() - _used < _hugeRun) return noSuchFrame;
+  if (_hugeRun < 64) {
+    // runs are aligned, so a run never spans two words
+    uint64_t run = (uint64_t(1) << _hugeRun) - 1;
+    for (size_t head = 0; head + _hugeRun <= size(); head += _hugeRun)
+      if ((_freeBits[head / 64] >> head % 64 & run) == run) return head;
+    return noSuchFrame;
+  }
+  size_t words = _hugeRun / 64;
+  for (size_t head = 0; head + _hugeRun <= size(); head += _hugeRun) {
+    size_t w = head / 64;
+    while (w < (head + _hugeRun) / 64 && _freeBits[w] == ~uint64_t(0)) w++;
+    if (w == head / 64 + words) return head;
+  }
   return noSuchFrame;
 }
 
-FrameNumber RAM::findOldest() {
-  FrameNumber oldest = 0;
-  EventTime ts = (*this)[oldest].timestamp();
-  for (size_t i = 0; i < (*this).size(); i++)
-    if ((*this)[i].timestamp() < ts) {
-      ts = (*this)[i].timestamp();
-      oldest = i;
+// mark pte as mapping no frame
+static void unmapped(PTE& pte) {
+  pte.frame(noSuchFrame);
+  pte.present(false);
+  pte.dirty(false);
+}
+
+void RAM::evict(FrameNumber f) {
+  PTE* owner = _mapping[f];
+  if (owner == nullptr) return;
+  size_t run = owner->large() ? _hugeRun : 1;
+  for (size_t i = 1; i < run; i++) give(f + i);
+  _used -= run;
+  (*this)[f].prefetched(false);
+  if ((*this)[f].mappings() > 1) {
+    auto sharers = _sharers.find(f);
+    for (PTE* pte : sharers->second) unmapped(*pte);
+    _sharers.erase(sharers);
+  }
+  unmapped(*owner);
+  _mapping[f] = nullptr;
+  (*this)[f].mappings(0);
+}
+
+void RAM::share(PTE& pte) {
+  FrameNumber f = pte.frame();
+  _sharers[f].push_back(&pte);
+  count(f);
+}
+
+void RAM::unmap(FrameNumber f, PTE& pte) {
+  auto sharers = _sharers.find(f);
+  std::vector<PTE*>& others = sharers->second;
+  if (_mapping[f] == &pte) {
+    _mapping[f] = others.back();
+    others.pop_back();
+  } else {
+    std::erase(others, &pte);
+  }
+  if (others.empty()) _sharers.erase(sharers);
+  unmapped(pte);
+  count(f);
+}
+
+void RAM::count(FrameNumber f) {
+  auto sharers = _sharers.find(f);
+  size_t n = _mapping[f] == nullptr ? 0 : 1;
+  if (sharers != _sharers.end()) n += sharers->second.size();
+  (*this)[f].mappings(n);
+}
+
+bool RAM::dirty(FrameNumber f) const {
+  if (_mapping[f] == nullptr) return false;
+  if (_mapping[f]->dirty()) return true;
+  if ((*this)[f].mappings() < 2) return false;
+  for (const PTE* pte : _sharers.at(f))
+    if (pte->dirty()) return true;
+  return false;
+}
+
+void RAM::charge(FrameNumber f, ProcessId process) {
+  size_t run = _mapping[f] != nullptr && _mapping[f]->large() ? _hugeRun : 1;
+  for (size_t i = 0; i < run; i++) (*this)[f + i].process(process);
+}
+
+bool RAM::release(FrameNumber f, ReplacementPolicy& policy) {
+  bool wasDirty = dirty(f);
+  policy.evicted(f, *this);
+  evict(f);
+  give(f);
+  return wasDirty;
+}
+
+size_t RAM::releaseProcess(PageTable& pageTable, ReplacementPolicy& policy) {
+  std::vector<std::pair<FrameNumber, PTE*>> mapped;
+  pageTable.forEachOwned([&mapped](PageNumber, PTE& pte) {
+    if (pte.present()) mapped.emplace_back(pte.frame(), &pte);
+  });
+  std::sort(mapped.begin(), mapped.end());
+  size_t before = _used;
+  for (auto [f, pte] : mapped) {
+    if ((*this)[f].mappings() > 1) {
+      unmap(f, *pte);
+      continue;
     }
-  return oldest;
+    pte->dirty(false);  // an exited process's pages are not kept
+    release(f, policy);
+  }
+  return before - _used;
 }
 
-FrameNumber RAM::load(PageNumber p, PageTable& pageTable, bool useTimestamp) {
-  // **** Part 1 *****
+FrameNumber RAM::choose(ProcessId process, PageNumber p,
+                        ReplacementPolicy& policy, bool local,
+                        bool prefetchesFirst) {
+  policy.loading(process, p, *this);
   FrameNumber free = findFree();
-  if (useTimestamp) {
-    if (free == noSuchFrame) free = findOldest();
-  } else {
-    PageNumber k = pageTable.findUnreferenced();
-    if (k != noSuchPage) free = k;
-    for (auto i : pageTable)
-      if (i.present()) {
-        free = i.frame();
-        break;
-      }
+  if (free == noSuchFrame && local && prefetchesFirst)
+    free = unusedPrefetch(process);
+  if (free == noSuchFrame && local) free = policy.victim(*this, p, process);
+  if (free == noSuchFrame && prefetchesFirst)
+    free = unusedPrefetch(noSuchProcess);
+  if (free == noSuchFrame) free = policy.victim(*this, p, noSuchProcess);
+  return free;
+}
+
+bool RAM::stale(const std::pair<FrameNumber, EventTime>& prefetch) const {
+  const Frame& frame = (*this)[prefetch.first];
+  return !frame.prefetched() || frame.timestamp() != prefetch.second;
+}
+
+FrameNumber RAM::unusedPrefetch(ProcessId owner) {
+  while (!_prefetches.empty() && stale(_prefetches.front()))
+    _prefetches.pop_front();
+  for (const auto& prefetch : _prefetches)
+    if (!stale(prefetch) && (owner == noSuchProcess ||
+                             (*this)[prefetch.first].process() == owner))
+      return prefetch.first;
+  return noSuchFrame;
+}
+
+void RAM::vacate(FrameNumber f, ReplacementPolicy& policy) {
+  _lastEvicted = noSuchPage;
+  _lastEvictedProcess = noSuchProcess;
+  _lastEvictedDirty = false;
+  _lastEvictedHuge = false;
+  if (_mapping[f] != nullptr) {
+    _lastEvicted = (*this)[f].page();
+    _lastEvictedProcess = (*this)[f].process();
+    _lastEvictedDirty = dirty(f);
+    _lastEvictedHuge = _mapping[f]->large();
+    policy.evicted(f, *this);
   }
+  evict(f);
+}
+
+void RAM::place(FrameNumber f, ProcessId process, PageNumber p, PTE& pte,
+                ReplacementPolicy& policy) {
+  size_t run = pte.large() ? _hugeRun : 1;
+  for (size_t i = 0; i < run; i++) {
+    take(f + i);
+    (*this)[f + i].page(p + i);
+    (*this)[f + i].process(process);
+  }
+  _used += run;
+  pte.frame(f);
+  pte.present(true);
+  _mapping[f] = &pte;
+  (*this)[f].mappings(1);
+  policy.loaded(f, *this);
+}
+
+FrameNumber RAM::load(ProcessId process, PageNumber p, PageTable& pageTable,
+                      ReplacementPolicy& policy, bool local) {
+  // **** Part 1 *****
+  FrameNumber free = choose(process, p, policy, local);
 
   // **** Part 2 *****
   if (free == noSuchFrame)
@@ -41,23 +211,158 @@ FrameNumber RAM::load(PageNumber p, PageTable& pageTable, bool useTimestamp) {
               << std::endl;
 
   // **** Part 3 *****
-  PageNumber p2 = pageTable.findByFrame(free);
-  while (noSuchPage != p2) {
-    pageTable[p2].frame(noSuchFrame);
-    pageTable[p2].present(false);
-    p2 = pageTable.findByFrame(free);
-  }
+  vacate(free, policy);
 
   // **** Part 4 *****
-  (*this)[free].free(false);
-  (*this)[free].page(p);
-  pageTable[p].frame(free);
-  pageTable[p].present(true);
+  place(free, process, p, pageTable[p], policy);
   return free;
 }
 
+FrameNumber RAM::loadHuge(ProcessId process, PageNumber p,
+                          PageTable& pageTable, ReplacementPolicy& policy,
+                          bool local) {
+  PageNumber first = p & ~PageNumber(_hugeRun - 1);
+  _lastLoadHuge = false;
+  FrameNumber head = findFreeRun();
+  if (head == noSuchFrame) {
+    // with a free frame there is no victim to take a run from
+    if (findFree() != noSuchFrame)
+      return load(process, p, pageTable, policy, local);
+    FrameNumber victim = choose(process, p, policy, local);
+    bool hugeVictim = _mapping[victim] != nullptr && _mapping[victim]->large();
+    vacate(victim, policy);
+    if (!hugeVictim) {
+      place(victim, process, p, pageTable[p], policy);
+      return victim;
+    }
+    head = victim;
+  } else {
+    vacate(head, policy);
+  }
+  PTE& pte = pageTable.huge(first);
+  pte.large(true);
+  place(head, process, first, pte, policy);
+  _lastLoadHuge = true;
+  return head + (p - first);
+}
+
+FrameNumber RAM::prefetch(ProcessId process, PageNumber p,
+                          PageTable& pageTable, ReplacementPolicy& policy,
+                          bool local, EventTime now) {
+  FrameNumber f = choose(process, p, policy, local, false);
+  if (f == noSuchFrame ||
+      (_mapping[f] != nullptr && (*this)[f].timestamp() == now))
+    return noSuchFrame;
+  vacate(f, policy);
+  place(f, process, p, pageTable[p], policy);
+  (*this)[f].prefetched(true);
+  (*this)[f].timestamp(now);
+  // at most one entry per frame is not stale, so dropping the stale ones
+  // when there are twice as many entries as frames takes constant time per
+  // prefetch, amortized
+  if (_prefetches.size() >= 2 * size())
+    std::erase_if(_prefetches, [this](const auto& entry) {
+      return stale(entry);
+    });
+  _prefetches.emplace_back(f, now);
+  return f;
+}
+
+// a PTE of a snapshot, by a process and page that reach it
+struct PteName {
+  ProcessId process;
+  PageNumber page;
+  bool large;
+};
+
+void RAM::save(SnapshotWriter& out, const ProcessTable& processes) const {
+  out.put(size());
+  out.put(_hugeRun);
+  out.putArray(std::span<const Frame>(data(), size()));
+  std::unordered_map<const PTE*, PteName> names;
+  for (ProcessId pid : processes.pids()) {
+    const PageTable& table = *processes.find(pid);
+    table.forEach([&names, pid](PageNumber p, const PTE& pte) {
+      if (pte.present()) names.try_emplace(&pte, PteName{pid, p, false});
+    });
+    table.forEachHuge([&names, pid](PageNumber p, const PTE& pte) {
+      if (pte.present()) names.try_emplace(&pte, PteName{pid, p, true});
+    });
+  }
+  auto putName = [&out, &names](const PTE* pte) {
+    const PteName& name = names.at(pte);
+    out.put(name.process);
+    out.put(name.page);
+    out.put(name.large);
+  };
+  for (FrameNumber f = 0; f < size(); f++) {
+    if (_mapping[f] == nullptr) continue;
+    out.put(f);
+    auto sharers = _sharers.find(f);
+    out.put(sharers == _sharers.end() ? 1 : 1 + sharers->second.size());
+    putName(_mapping[f]);
+    if (sharers != _sharers.end())
+      for (const PTE* pte : sharers->second) putName(pte);
+  }
+  out.put(noSuchFrame);
+  out.put(_prefetches.size());
+  for (const auto& [f, loaded] : _prefetches) {
+    out.put(f);
+    out.put(loaded);
+  }
+}
+
+void RAM::restore(SnapshotReader& in, ProcessTable& processes) {
+  in.expect(size(), "number of frames");
+  in.expect(_hugeRun, "huge page size");
+  std::span<const Frame> frames = in.getArray<Frame>();
+  if (frames.size() != size())
+    throw std::runtime_error("bad RAM in snapshot");
+  std::copy(frames.begin(), frames.end(), begin());
+  _used = 0;
+  _firstFree = 0;
+  for (FrameNumber f = 0; f < size(); f++) {
+    _mapping[f] = nullptr;
+    if ((*this)[f].free()) {
+      _freeBits[f / 64] |= uint64_t(1) << f % 64;
+      continue;
+    }
+    _freeBits[f / 64] &= ~(uint64_t(1) << f % 64);
+    _used++;
+  }
+  _sharers.clear();
+  for (FrameNumber f; (f = in.get()) != noSuchFrame;) {
+    if (f >= size() || (*this)[f].free() || _mapping[f] != nullptr)
+      throw std::runtime_error("bad RAM in snapshot");
+    for (uint64_t n = in.get(); n-- > 0;) {
+      ProcessId pid = in.get();
+      PageNumber p = in.get();
+      bool large = in.get();
+      PageTable* table = processes.find(pid);
+      PTE* pte = table == nullptr ? nullptr : table->at(p, large);
+      if (pte == nullptr || !pte->present() || pte->frame() != f)
+        throw std::runtime_error("bad RAM in snapshot");
+      if (_mapping[f] == nullptr)
+        _mapping[f] = pte;
+      else
+        _sharers[f].push_back(pte);
+    }
+  }
+  for (FrameNumber f = 0; f < size(); f++) count(f);
+  _prefetches.clear();
+  for (uint64_t n = in.get(); n-- > 0;) {
+    FrameNumber f = in.get();
+    EventTime loaded = in.get();
+    if (f >= size()) throw std::runtime_error("bad RAM in snapshot");
+    _prefetches.emplace_back(f, loaded);
+  }
+  _lastEvicted = noSuchPage;
+  _lastEvictedProcess = noSuchProcess;
+  _lastEvictedDirty = _lastEvictedHuge = _lastLoadHuge = false;
+}
+
 std::ostream& operator<<(std::ostream& out, const RAM& ram) {
   for (int i = 0; i < (int)ram.size(); i++)
-    out << "  " << i << " " << ram[i] << std::endl;
+    out << "  " << i << " " << ram[i] << "\n";
   return out;
 }
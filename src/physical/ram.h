@@ -10,19 +10,53 @@
 #ifndef RAM_H
 #define RAM_H
 #include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "frame.h"
 #include "pageTable.h"
+#include "replacementPolicy.h"
 #include "virtualMemoryTypes.h"
 
+class ProcessTable;
+class SnapshotReader;
+class SnapshotWriter;
+
 /**
  * RAM is vector of Frame objects indexed by their FrameNumber.
  *
  * It takes a size parameter on construction and is expected to remain fixed.
  *
  * All Frame are initially free (their .free() method returns true). Once
- * content has been put into a Frame, it will never again be free.
+ * content has been put into a Frame it stays in use until it is released
+ * (see release()).
+ *
+ * RAM also keeps the inverted mapping from each FrameNumber to the PTE that
+ * maps it, so evicting a frame never has to search the PageTable. Frames are
+ * shared by every process; each Frame records the (process, page) it holds.
+ *
+ * After a FORK several PTE may map one frame, copy-on-write: the first is
+ * the frame's mapping(), the others are kept in a hash table by frame (empty
+ * unless processes share frames), and the Frame counts them all. Evicting a
+ * shared frame unmaps it from every PTE. A shared frame stays charged to
+ * the process that loaded it while that process lives.
+ *
+ * With huge pages a huge page occupies an aligned run of frames. Only the
+ * first frame of the run has a mapping (the huge page PTE), so replacement
+ * policies, which only manage mapped frames, see a huge page as one frame;
+ * evicting it frees the whole run.
+ *
+ * The free frames are also kept in a bitmap, one bit per frame, so finding
+ * one is a count-trailing-zeros over 64 frames at a time instead of a walk
+ * over every Frame; once RAM is full it takes constant time.
+ *
+ * Pages loaded ahead of demand by prefetch() are marked in their Frame until
+ * they are first used. When no frame is free, the oldest unused prefetch is
+ * replaced before the policy is asked for a victim, so a wrong prediction
+ * costs a frame only until the next load.
  */
 class RAM : public std::vector<Frame> {
  public:
@@ -35,22 +69,133 @@ class RAM : public std::vector<Frame> {
    */
   RAM(const size_t n);
 
+  /**
+   * Allow huge pages of run frames each (a power of two).
+   */
+  void hugePages(size_t run) { _hugeRun = run; }
+
+  /**
+   * @return frames in a huge page; 0 if huge pages are not allowed
+   */
+  size_t hugeRun() const { return _hugeRun; }
+
+  /**
+   * @return number of frames in use (every frame of a huge page counts)
+   */
+  size_t used() const { return _used; }
+
   /**
    * Find the FrameNumber of a free frame, if one exists [from ram].
    *
+   * Searches the bitmap from the lowest word that may hold a free frame, so
+   * the cost is that of the words skipped, amortized over the frames taken.
+   *
    * @return lowest valid FrameNumber of a free Frame if one exists; noSuchFrame
    * if there are no free Frame in the RAM
    */
   FrameNumber findFree();
 
   /**
-   * Find the FrameNumber of the Frame with the lowest referenced time stamp
-   * [from ram].
+   * Find the first frame of an aligned run of hugeRun() free frames.
+   *
+   * @return lowest such FrameNumber; noSuchFrame if there is none
+   */
+  FrameNumber findFreeRun() const;
+
+  /**
+   * Get the PTE currently mapping the given frame.
    *
-   * @return FrameNumber of Frame where .referenced() method is the minimum
-   * across RAM
+   * @param f FrameNumber to look up
+   * @return pointer to the PTE holding f; nullptr if nothing is mapped there
+   */
+  PTE* mapping(FrameNumber f) const { return _mapping[f]; }
+
+  /**
+   * Add pte, a copy of a PTE mapping a present page (made by
+   * PageTable::unshare()), as another mapping of its frame.
+   */
+  void share(PTE& pte);
+
+  /**
+   * Remove pte from the mappings of frame f, which has others, e.g. for a
+   * copy-on-write fault; pte is marked not present, with noSuchFrame as
+   * frame#. The frame stays in use.
+   */
+  void unmap(FrameNumber f, PTE& pte);
+
+  /**
+   * @return true if some PTE mapping frame f is dirty
+   */
+  bool dirty(FrameNumber f) const;
+
+  /**
+   * Charge the page in frame f (and the rest of a huge page's run) to
+   * process, e.g. when the process that loaded a shared page has exited.
+   */
+  void charge(FrameNumber f, ProcessId process);
+
+  /**
+   * Unmap whatever page currently occupies the given frame.
+   *
+   * Uses the inverted mapping, so it runs in constant time (per PTE
+   * mapping it). Each PTE is marked not present and clean (a dirty page is
+   * written back) and its FrameNumber reset to noSuchFrame. The Frame
+   * keeps its old page and timestamp until it is reloaded; the rest of a
+   * huge page's run is freed.
+   *
+   * @param f FrameNumber to evict; ignored if nothing is mapped there
+   */
+  void evict(FrameNumber f);
+
+  /**
+   * Give a frame back: evict its page and make the Frame free again, so the
+   * next load may use it.
+   *
+   * @param f FrameNumber to release; it must be in use
+   * @param policy the replacement policy; it is told about the eviction
+   * @return true if the page was dirty, so it had to be written back
+   */
+  bool release(FrameNumber f, ReplacementPolicy& policy);
+
+  /**
+   * Give back every frame of a process that has exited, in frame order: its
+   * pages are dropped without being written back and the frames are free
+   * again. Frames that other processes still map (through tables of their
+   * own) are only unmapped from the exiting process's PTE; tables it shares
+   * are left as they are.
+   *
+   * @param pageTable the page table of the process
+   * @param policy the replacement policy; it is told about each eviction
+   * @return the number of frames freed (every frame of a huge page counts)
+   */
+  size_t releaseProcess(PageTable& pageTable, ReplacementPolicy& policy);
+
+  /**
+   * @return the page evicted by the last call to load(); noSuchPage if that
+   * load used a free frame
+   */
+  PageNumber lastEvicted() const { return _lastEvicted; }
+
+  /**
+   * @return true if the page evicted by the last call to load() was huge
    */
-  FrameNumber findOldest();
+  bool lastEvictedHuge() const { return _lastEvictedHuge; }
+
+  /**
+   * @return true if the last call to loadHuge() loaded a huge page
+   */
+  bool lastLoadHuge() const { return _lastLoadHuge; }
+
+  /**
+   * @return the process whose page was evicted by the last call to load()
+   */
+  ProcessId lastEvictedProcess() const { return _lastEvictedProcess; }
+
+  /**
+   * @return true if the page evicted by the last call to load() was dirty,
+   * so it had to be written back
+   */
+  bool lastEvictedDirty() const { return _lastEvictedDirty; }
 
   /**
    * Simulate loading a Frame with the contents of a given page.
@@ -61,29 +206,145 @@ class RAM : public std::vector<Frame> {
    *
    * Part 1:
    * Load the page to the lowest numbered free frame FrameNumber if there are
-   * any.
-   * Select a FrameNumber to evict from RAM by the lowest .referenced() time of
-   * the Frame if useTimestamp is true, otherwise the FrameNumber in the lowest
-   * PageNumber that has a zero .reference() bit, if one exists, and if none
-   * exists the FrameNumber of the lowest PageNumber that is .present() in RAM.
+   * any. Otherwise ask the replacement policy for a victim Frame: with local
+   * replacement one of the process's own frames, if it has any; else any
+   * Frame.
    *
    * Part 2:
    * Error checking, should never be called
    *
    * Part 3:
-   * Make sure any newly loaded frames aren't referenced in the PageTable. Mark
-   * them as not present, load noSuchFrame as frame#.
+   * Evict the page previously held in the frame through the inverted
+   * mapping. Its PTE is marked not present and clean, with noSuchFrame as
+   * frame#.
    *
    * Part 4:
-   * Put 'data' into Frame. Put new PTE into PageTable
+   * Put 'data' into Frame. Put new PTE into PageTable and record it as the
+   * frame's mapping.
    *
+   * @param process the process the page belongs to
    * @param p the PageNumber to load into RAM
-   * @param pageTable the table of PTE; may be modified by loading
-   * @param useTimestamp use Frame timestamps if true; use PTE referenced bits
-   * if not.
+   * @param pageTable the process's table of PTE; may be modified by loading
+   * @param policy the replacement policy choosing the victim; it is told
+   * about the eviction and the load.
+   * @param local true to replace one of the process's own frames if it can
    */
-  FrameNumber load(PageNumber p, PageTable& pageTable,
-                   bool useTimestamp = true);
+  FrameNumber load(ProcessId process, PageNumber p, PageTable& pageTable,
+                   ReplacementPolicy& policy, bool local);
+
+  /**
+   * Load the huge page holding page p into an aligned run of frames, if one
+   * can be had: a free run, or the run of a huge page the policy picks as
+   * the victim when no frame is free. Otherwise (free frames, but no free
+   * run: fragmentation; or a base page victim) load p alone, as load() does.
+   * lastLoadHuge() tells which happened.
+   *
+   * @param process the process the page belongs to
+   * @param p the PageNumber accessed
+   * @param pageTable the process's table; huge pages must be allowed in it
+   * @param policy the replacement policy choosing the victim
+   * @param local true to replace one of the process's own frames if it can
+   * @return the frame holding p (within the run of a huge page)
+   */
+  FrameNumber loadHuge(ProcessId process, PageNumber p, PageTable& pageTable,
+                       ReplacementPolicy& policy, bool local);
+
+  /**
+   * Load page p ahead of demand (a prefetch) into a free frame, else over
+   * the policy's victim, unless that holds a page loaded or used at time
+   * now: the page whose fault made the prediction, or an earlier prefetch
+   * for it. Unlike load(), a prefetch does not replace the unused prefetches
+   * first: they were predicted to be needed sooner.
+   * The frame is marked prefetched and stamped with time now; the MMU
+   * clears the mark when the page is first used.
+   *
+   * @param process the process the page belongs to
+   * @param p the PageNumber to load; it must not be present
+   * @param pageTable the process's table of PTE
+   * @param policy the replacement policy choosing the victim
+   * @param local true to replace one of the process's own frames if it can
+   * @param now the event clock of the access that made the prediction
+   * @return the frame loaded; noSuchFrame if none could be used
+   */
+  FrameNumber prefetch(ProcessId process, PageNumber p, PageTable& pageTable,
+                       ReplacementPolicy& policy, bool local, EventTime now);
+
+  /**
+   * Save every Frame, as one array, the PTE mapping each frame, each named
+   * by a process and page of processes that reach it, and the unused
+   * prefetches to a snapshot.
+   */
+  void save(SnapshotWriter& out, const ProcessTable& processes) const;
+
+  /**
+   * Restore the frames saved to a snapshot, mapping each one to the PTE
+   * named in processes, which must already be restored.
+   *
+   * @throw std::runtime_error if RAM was saved with another size or huge
+   *        page size, or the snapshot is bad
+   */
+  void restore(SnapshotReader& in, ProcessTable& processes);
+
+ private:
+  /**
+   * The frame to load into: the lowest free one, else (if prefetchesFirst)
+   * the oldest unused prefetch, else the policy's victim.
+   */
+  FrameNumber choose(ProcessId process, PageNumber p,
+                     ReplacementPolicy& policy, bool local,
+                     bool prefetchesFirst = true);
+
+  /**
+   * The oldest prefetched page still unused, of owner (any process for
+   * noSuchProcess).
+   *
+   * @return its frame; noSuchFrame if there is none
+   */
+  FrameNumber unusedPrefetch(ProcessId owner);
+
+  /**
+   * Is the entry of _prefetches no longer an unused prefetch?
+   */
+  bool stale(const std::pair<FrameNumber, EventTime>& prefetch) const;
+
+  /**
+   * Evict whatever page is in frame f, remembering it as the last evicted.
+   */
+  void vacate(FrameNumber f, ReplacementPolicy& policy);
+
+  /**
+   * Put the page that pte maps into frame f (and, for a huge page, the run
+   * it heads).
+   */
+  void place(FrameNumber f, ProcessId process, PageNumber p, PTE& pte,
+             ReplacementPolicy& policy);
+
+  /**
+   * Mark frame f in use / free, in the Frame and in the bitmap.
+   */
+  void take(FrameNumber f);
+  void give(FrameNumber f);
+
+  /**
+   * Set frame f's count of mappings from _mapping and _sharers.
+   */
+  void count(FrameNumber f);
+
+  std::vector<PTE*> _mapping;
+  // the PTE mapping each shared frame, besides _mapping
+  std::unordered_map<FrameNumber, std::vector<PTE*>> _sharers;
+  std::vector<uint64_t> _freeBits;  // bit f % 64 of word f / 64: f is free
+  size_t _firstFree{0};  // no word before this one has a free frame
+  // each prefetch, oldest first, with the time it was loaded; an entry is
+  // stale once its frame is used, evicted or loaded again
+  std::deque<std::pair<FrameNumber, EventTime>> _prefetches;
+  size_t _hugeRun{0};
+  size_t _used{0};
+  bool _lastEvictedHuge{false};
+  bool _lastLoadHuge{false};
+  PageNumber _lastEvicted{noSuchPage};
+  ProcessId _lastEvictedProcess{noSuchProcess};
+  bool _lastEvictedDirty{false};
 };
 
 /**
@@ -0,0 +1,126 @@
+#include "arcPolicy.h"
+
+#include <algorithm>
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("ARC", makePolicyOf<ArcPolicy>);
+
+void ArcPolicy::reset(const RAM& ram) {
+  _size = ram.size();
+  _target = 0;
+  _lists.reset(ram.size(), 2);
+  _b1.clear();
+  _b2.clear();
+  _fresh.assign(ram.size(), false);
+  _loadingPage = noSuchPage;
+  _ghost = nullptr;
+
+  std::vector<FrameNumber> resident;
+  for (FrameNumber f = 0; f < ram.size(); f++)
+    if (ram.mapping(f) != nullptr) resident.push_back(f);
+  std::stable_sort(resident.begin(), resident.end(),
+                   [&ram](FrameNumber a, FrameNumber b) {
+                     return ram[a].timestamp() < ram[b].timestamp();
+                   });
+  for (FrameNumber f : resident) _lists.pushBack(T1, f);
+}
+
+void ArcPolicy::loading(ProcessId process, PageNumber p, const RAM& ram) {
+  _loadingProcess = process;
+  _loadingPage = p;
+  _ghost = nullptr;
+  size_t b1 = _b1.size();
+  size_t b2 = _b2.size();
+  if (_b1.erase(process, p)) {
+    _b1Hits++;
+    _target = std::min(_size, _target + std::max<size_t>(b2 / b1, 1));
+    _ghost = &_b1;
+  } else if (_b2.erase(process, p)) {
+    _b2Hits++;
+    _target -= std::min(_target, std::max<size_t>(b1 / b2, 1));
+    _ghost = &_b2;
+  }
+}
+
+FrameNumber ArcPolicy::victim(const RAM& ram, PageNumber incoming,
+                              ProcessId owner) {
+  size_t t1 = _lists.size(T1);
+  bool inB2 = _ghost == &_b2 && incoming == _loadingPage;
+  bool fromT1 = t1 > 0 && (t1 > _target || (t1 == _target && inB2));
+  FrameNumber f = oldest(fromT1 ? T1 : T2, ram, owner);
+  if (f == noSuchFrame) f = oldest(fromT1 ? T2 : T1, ram, owner);
+  return f;
+}
+
+FrameNumber ArcPolicy::oldest(List list, const RAM& ram,
+                              ProcessId owner) const {
+  for (FrameNumber f = _lists.front(list); f != noSuchFrame;
+       f = _lists.next(f))
+    if (owner == noSuchProcess || ram[f].process() == owner) return f;
+  return noSuchFrame;
+}
+
+void ArcPolicy::loaded(FrameNumber f, const RAM& ram) {
+  bool returning = _ghost != nullptr && ram[f].page() == _loadingPage &&
+                   ram[f].process() == _loadingProcess;
+  _lists.pushBack(returning ? T2 : T1, f);
+  _fresh[f] = true;
+  _loadingPage = noSuchPage;
+  _ghost = nullptr;
+  trim();
+}
+
+void ArcPolicy::trim() {
+  while (_lists.size(T1) + _b1.size() > _size && !_b1.empty())
+    _b1.popBack();
+  size_t total = _lists.size(T1) + _lists.size(T2) + _b1.size() + _b2.size();
+  for (; total > 2 * _size && !(_b1.empty() && _b2.empty()); total--)
+    (_b2.empty() ? _b1 : _b2).popBack();
+}
+
+void ArcPolicy::touched(FrameNumber f, const RAM& ram) {
+  if (_fresh[f]) {
+    _fresh[f] = false;
+    return;
+  }
+  _lists.pushBack(T2, f);
+}
+
+void ArcPolicy::evicted(FrameNumber f, const RAM& ram) {
+  unsigned list = _lists.list(f);
+  if (list == T1) _b1.pushFront(ram[f].process(), ram[f].page());
+  if (list == T2) _b2.pushFront(ram[f].process(), ram[f].page());
+  _lists.remove(f);
+  _fresh[f] = false;
+}
+
+std::vector<PolicyCounter> ArcPolicy::counters() const {
+  return {{"B1 hits", _b1Hits}, {"B2 hits", _b2Hits}};
+}
+
+void ArcPolicy::save(SnapshotWriter& out) const {
+  _lists.save(out);
+  _b1.save(out);
+  _b2.save(out);
+  out.put(_target);
+  std::vector<FrameNumber> fresh;
+  for (FrameNumber f = 0; f < _fresh.size(); f++)
+    if (_fresh[f]) fresh.push_back(f);
+  out.putArray(fresh);
+  out.put(_b1Hits);
+  out.put(_b2Hits);
+}
+
+void ArcPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _lists.restore(in);
+  _b1.restore(in);
+  _b2.restore(in);
+  _target = std::min<size_t>(in.get(), _size);
+  _fresh.assign(ram.size(), false);
+  for (FrameNumber f : in.getArray<FrameNumber>())
+    if (f < ram.size()) _fresh[f] = true;
+  _b1Hits = in.get();
+  _b2Hits = in.get();
+}
@@ -0,0 +1,112 @@
+/**
+ * ArcPolicy implements Adaptive Replacement Cache (the ARC command), after
+ * Megiddo and Modha, "ARC: A Self-Tuning, Low Overhead Replacement Cache"
+ * (FAST 2003).
+ *
+ * Resident frames are on two LRU lists: T1, pages used once since they were
+ * loaded, and T2, pages used again. Two ghost lists remember the pages
+ * lately evicted from each, B1 and B2. A fault on a page in B1 means T1 was
+ * too small, one in B2 that T2 was; either moves the target size of T1 (p)
+ * toward the list that would have kept the page, and brings the page back
+ * into T2. The victim is the oldest page of T1 while T1 is over its target,
+ * else the oldest of T2. A sequential scan only passes through T1 and B1, so
+ * it cannot flush the pages in T2 the way it flushes LRU.
+ *
+ * All four lists take O(1) per operation: the resident ones are linked by
+ * FrameNumber (FrameLists), the ghosts hashed by page (GhostList).
+ */
+
+#ifndef ARCPOLICY_H
+#define ARCPOLICY_H
+
+#include <vector>
+
+#include "frameLists.h"
+#include "ghostList.h"
+#include "replacementPolicy.h"
+
+class ArcPolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "ARC"; }
+
+  /**
+   * Put every mapped Frame on T1, oldest timestamp first; no ghosts, and a
+   * target of 0 for T1.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * If the page is on a ghost list, take it off and move the target toward
+   * that list's side: by 1, or by the ratio of the other ghost list's size
+   * to its own if that is more.
+   */
+  void loading(ProcessId process, PageNumber p, const RAM& ram) override;
+
+  /**
+   * @return the oldest frame of T1 if T1 is over its target (or at it,
+   * when the incoming page is in B2), else the oldest of T2; for local
+   * replacement, the oldest of owner's frames in that order
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  /**
+   * Put the page on T2 if it came back from a ghost list, else on T1. Then
+   * forget the oldest ghosts until T1 and B1 together hold at most as many
+   * pages as RAM has frames, and all four lists at most twice as many.
+   */
+  void loaded(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Move a page used again to the back of T2. The access that loaded a page
+   * (or, for a prefetched page, its first use) does not count.
+   */
+  void touched(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Remember the page on the ghost list of its list.
+   */
+  void evicted(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Faults on pages found in B1 and in B2.
+   */
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the four lists, the target and the counters.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  enum List : unsigned { T1, T2 };
+
+  /**
+   * The oldest frame of list that belongs to owner (any process for
+   * noSuchProcess); noSuchFrame if there is none.
+   */
+  FrameNumber oldest(List list, const RAM& ram, ProcessId owner) const;
+
+  /**
+   * Forget ghosts, oldest first, to keep the lists within their bounds.
+   */
+  void trim();
+
+  FrameLists _lists;
+  GhostList _b1;
+  GhostList _b2;
+  size_t _size{0};    // c: frames in RAM
+  size_t _target{0};  // p: the size T1 should have
+  std::vector<bool> _fresh;  // loaded, not yet used again
+
+  // the page being loaded and the ghost list it was found on, if any
+  ProcessId _loadingProcess{noSuchProcess};
+  PageNumber _loadingPage{noSuchPage};
+  const GhostList* _ghost{nullptr};
+
+  unsigned long _b1Hits{0};
+  unsigned long _b2Hits{0};
+};
+
+#endif /* ARCPOLICY_H */
@@ -0,0 +1,45 @@
+#include "clockPolicy.h"
+
+#include <stdexcept>
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("CLOCK", makePolicyOf<ClockPolicy>);
+
+void ClockPolicy::reset(const RAM& ram) { _hand = 0; }
+
+FrameNumber ClockPolicy::victim(const RAM& ram, PageNumber incoming,
+                                ProcessId owner) {
+  // at most two passes: the first may clear every referenced bit
+  for (size_t step = 0; step < 2 * ram.size(); step++) {
+    FrameNumber f = _hand;
+    _hand = (_hand + 1) % ram.size();
+    _sweeps++;
+    PTE* pte = ram.mapping(f);
+    if (pte == nullptr) continue;
+    if (owner != noSuchProcess && ram[f].process() != owner) continue;
+    if (!pte->referenced()) return f;
+    pte->referenced(false);
+    _secondChances++;
+  }
+  return noSuchFrame;
+}
+
+std::vector<PolicyCounter> ClockPolicy::counters() const {
+  return {{"sweeps", _sweeps}, {"second chances", _secondChances}};
+}
+
+void ClockPolicy::save(SnapshotWriter& out) const {
+  out.put(_hand);
+  out.put(_sweeps);
+  out.put(_secondChances);
+}
+
+void ClockPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _hand = in.get();
+  if (_hand >= ram.size())
+    throw std::runtime_error("bad CLOCK policy in snapshot");
+  _sweeps = in.get();
+  _secondChances = in.get();
+}
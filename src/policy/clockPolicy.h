@@ -0,0 +1,49 @@
+/**
+ * ClockPolicy implements the CLOCK (second chance) approximation of LRU.
+ *
+ * A hand sweeps the frames in FrameNumber order. A frame whose page has its
+ * referenced bit set gets a second chance: the bit is cleared and the hand
+ * moves on. The first frame found with a clear bit is the victim. Touching a
+ * page costs nothing beyond the referenced bit the command loop already sets.
+ */
+
+#ifndef CLOCKPOLICY_H
+#define CLOCKPOLICY_H
+
+#include "replacementPolicy.h"
+
+class ClockPolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "CLOCK"; }
+
+  /**
+   * Put the hand back on Frame 0.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * Sweep from the hand, clearing referenced bits, to the first frame with
+   * an unreferenced page. Leaves the hand just past the victim. For local
+   * replacement the frames of other processes are passed over untouched.
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  /**
+   * Frames the hand swept past and second chances given.
+   */
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the hand and the counters.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  FrameNumber _hand{0};
+  unsigned long _sweeps{0};
+  unsigned long _secondChances{0};
+};
+
+#endif /* CLOCKPOLICY_H */
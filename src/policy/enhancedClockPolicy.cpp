@@ -0,0 +1,73 @@
+#include "enhancedClockPolicy.h"
+
+#include <stdexcept>
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("ESC",
+                                       makePolicyOf<EnhancedClockPolicy>);
+
+void EnhancedClockPolicy::reset(const RAM& ram) { _hand = 0; }
+
+PTE* EnhancedClockPolicy::advance(const RAM& ram, ProcessId owner,
+                                  FrameNumber& f) {
+  f = _hand;
+  _hand = (_hand + 1) % ram.size();
+  _sweeps++;
+  if (owner != noSuchProcess && ram[f].process() != owner) return nullptr;
+  return ram.mapping(f);
+}
+
+FrameNumber EnhancedClockPolicy::victim(const RAM& ram, PageNumber incoming,
+                                        ProcessId owner) {
+  FrameNumber f;
+  // at most four passes: the second may clear every referenced bit
+  for (int round = 0; round < 2; round++) {
+    // unreferenced and clean; nothing changes
+    for (size_t step = 0; step < ram.size(); step++) {
+      PTE* pte = advance(ram, owner, f);
+      if (pte != nullptr && !pte->referenced() && !pte->dirty()) {
+        _cleanVictims++;
+        return f;
+      }
+    }
+    // unreferenced (and so dirty); referenced pages get a second chance
+    for (size_t step = 0; step < ram.size(); step++) {
+      PTE* pte = advance(ram, owner, f);
+      if (pte == nullptr) continue;
+      if (!pte->referenced()) {
+        _dirtyVictims++;
+        return f;
+      }
+      pte->referenced(false);
+      _secondChances++;
+    }
+  }
+  return noSuchFrame;
+}
+
+std::vector<PolicyCounter> EnhancedClockPolicy::counters() const {
+  return {{"sweeps", _sweeps},
+          {"second chances", _secondChances},
+          {"clean victims", _cleanVictims},
+          {"dirty victims", _dirtyVictims}};
+}
+
+void EnhancedClockPolicy::save(SnapshotWriter& out) const {
+  out.put(_hand);
+  out.put(_sweeps);
+  out.put(_secondChances);
+  out.put(_cleanVictims);
+  out.put(_dirtyVictims);
+}
+
+void EnhancedClockPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _hand = in.get();
+  if (_hand >= ram.size())
+    throw std::runtime_error("bad ESC policy in snapshot");
+  _sweeps = in.get();
+  _secondChances = in.get();
+  _cleanVictims = in.get();
+  _dirtyVictims = in.get();
+}
@@ -0,0 +1,64 @@
+/**
+ * EnhancedClockPolicy implements enhanced second chance replacement (the ESC
+ * command), a CLOCK that prefers clean pages.
+ *
+ * Frames fall in four classes by the (referenced, dirty) bits of their
+ * pages. The hand first sweeps once looking for an unreferenced, clean page
+ * without changing anything; failing that it sweeps for an unreferenced,
+ * dirty page, clearing referenced bits as it goes; failing that it starts
+ * over. A clean victim needs no write-back, so this trades a little extra
+ * sweeping for less paging I/O.
+ */
+
+#ifndef ENHANCEDCLOCKPOLICY_H
+#define ENHANCEDCLOCKPOLICY_H
+
+#include "pte.h"
+#include "replacementPolicy.h"
+
+class EnhancedClockPolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "ESC"; }
+
+  /**
+   * Put the hand back on Frame 0.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * Find the first frame in the best (referenced, dirty) class from the
+   * hand. Leaves the hand just past the victim. For local replacement the
+   * frames of other processes are passed over untouched.
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  /**
+   * Frames the hand swept past, second chances given, and clean and dirty
+   * victims chosen.
+   */
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the hand and the counters.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  /**
+   * Move the hand one frame on.
+   *
+   * @return the PTE of the page in the frame the hand was on, if the frame
+   * is one the victim may be chosen from; nullptr otherwise
+   */
+  PTE* advance(const RAM& ram, ProcessId owner, FrameNumber& f);
+
+  FrameNumber _hand{0};
+  unsigned long _sweeps{0};
+  unsigned long _secondChances{0};
+  unsigned long _cleanVictims{0};
+  unsigned long _dirtyVictims{0};
+};
+
+#endif /* ENHANCEDCLOCKPOLICY_H */
@@ -0,0 +1,55 @@
+#include "frameLists.h"
+
+#include <span>
+#include <stdexcept>
+
+#include "snapshot.h"
+
+void FrameLists::reset(size_t frames, unsigned lists) {
+  _frames = frames;
+  _prev.assign(frames + lists, noSuchFrame);
+  _next.assign(frames + lists, noSuchFrame);
+  _list.assign(frames, none);
+  _sizes.assign(lists, 0);
+  for (unsigned l = 0; l < lists; l++)
+    _prev[head(l)] = _next[head(l)] = head(l);
+}
+
+void FrameLists::pushBack(unsigned list, FrameNumber f) {
+  remove(f);
+  FrameNumber last = _prev[head(list)];
+  _next[last] = f;
+  _prev[f] = last;
+  _next[f] = head(list);
+  _prev[head(list)] = f;
+  _list[f] = list;
+  _sizes[list]++;
+}
+
+void FrameLists::remove(FrameNumber f) {
+  if (_list[f] == none) return;
+  _next[_prev[f]] = _next[f];
+  _prev[_next[f]] = _prev[f];
+  _prev[f] = _next[f] = noSuchFrame;
+  _sizes[_list[f]]--;
+  _list[f] = none;
+}
+
+void FrameLists::save(SnapshotWriter& out) const {
+  for (unsigned l = 0; l < _sizes.size(); l++) {
+    std::vector<FrameNumber> order;
+    for (FrameNumber f = front(l); f != noSuchFrame; f = next(f))
+      order.push_back(f);
+    out.putArray(order);
+  }
+}
+
+void FrameLists::restore(SnapshotReader& in) {
+  reset(_frames, _sizes.size());
+  for (unsigned l = 0; l < _sizes.size(); l++)
+    for (FrameNumber f : in.getArray<FrameNumber>()) {
+      if (f >= _frames || _list[f] != none)
+        throw std::runtime_error("bad policy lists in snapshot");
+      pushBack(l, f);
+    }
+}
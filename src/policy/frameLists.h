@@ -0,0 +1,89 @@
+/**
+ * FrameLists keeps the resident frames of a policy on a few doubly-linked
+ * lists, each frame on at most one, oldest first.
+ *
+ * The links are indexed by FrameNumber (as in LruPolicy), so moving a frame
+ * to the back of a list, removing it and finding the oldest frame of a list
+ * are all O(1).
+ */
+
+#ifndef FRAMELISTS_H
+#define FRAMELISTS_H
+
+#include <vector>
+
+#include "virtualMemoryTypes.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+class FrameLists {
+ public:
+  // list() of a frame on no list
+  static constexpr unsigned none = ~0u;
+
+  /**
+   * Empty the given number of lists, for frames 0 to frames - 1.
+   */
+  void reset(size_t frames, unsigned lists);
+
+  /**
+   * Move f to the back (the newest end) of list, from whatever list it is
+   * on.
+   */
+  void pushBack(unsigned list, FrameNumber f);
+
+  /**
+   * Take f off its list, if it is on one.
+   */
+  void remove(FrameNumber f);
+
+  /**
+   * @return the oldest frame of list; noSuchFrame if it is empty
+   */
+  FrameNumber front(unsigned list) const { return step(_next[head(list)]); }
+
+  /**
+   * @return the frame after f on its list; noSuchFrame if f is the newest
+   */
+  FrameNumber next(FrameNumber f) const { return step(_next[f]); }
+
+  /**
+   * @return the list f is on; none if it is on no list
+   */
+  unsigned list(FrameNumber f) const { return _list[f]; }
+
+  /**
+   * @return the number of frames on list
+   */
+  size_t size(unsigned list) const { return _sizes[list]; }
+
+  /**
+   * Save each list to a snapshot, oldest first.
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * Replace the lists with those saved to a snapshot.
+   *
+   * @throw std::runtime_error if the snapshot is bad
+   */
+  void restore(SnapshotReader& in);
+
+ private:
+  // the sentinel of each list follows the frames
+  FrameNumber head(unsigned list) const { return _frames + list; }
+
+  // a link, or noSuchFrame for a sentinel
+  FrameNumber step(FrameNumber f) const {
+    return f >= _frames ? noSuchFrame : f;
+  }
+
+  FrameNumber _frames{0};
+  std::vector<FrameNumber> _prev;
+  std::vector<FrameNumber> _next;
+  std::vector<unsigned> _list;
+  std::vector<size_t> _sizes;
+};
+
+#endif /* FRAMELISTS_H */
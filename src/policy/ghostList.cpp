@@ -0,0 +1,43 @@
+#include "ghostList.h"
+
+#include "snapshot.h"
+
+void GhostList::pushFront(ProcessId process, PageNumber page) {
+  erase(process, page);
+  _order.push_front(Key{process, page});
+  _where[_order.front()] = _order.begin();
+}
+
+bool GhostList::erase(ProcessId process, PageNumber page) {
+  auto found = _where.find(Key{process, page});
+  if (found == _where.end()) return false;
+  _order.erase(found->second);
+  _where.erase(found);
+  return true;
+}
+
+void GhostList::popBack() {
+  _where.erase(_order.back());
+  _order.pop_back();
+}
+
+void GhostList::clear() {
+  _order.clear();
+  _where.clear();
+}
+
+void GhostList::save(SnapshotWriter& out) const {
+  out.put(_order.size());
+  for (auto key = _order.rbegin(); key != _order.rend(); ++key) {
+    out.put(key->first);
+    out.put(key->second);
+  }
+}
+
+void GhostList::restore(SnapshotReader& in) {
+  clear();
+  for (uint64_t n = in.get(); n-- > 0;) {
+    ProcessId process = in.get();
+    pushFront(process, in.get());
+  }
+}
@@ -0,0 +1,79 @@
+/**
+ * GhostList remembers pages recently evicted from RAM, most recent first,
+ * without their content: the history ARC and 2Q use to recognize a page
+ * that comes back soon after it was evicted.
+ *
+ * Pages are identified by process and page number. A hash map from each
+ * page to its place in the list makes looking a page up, adding it and
+ * removing it (anywhere, or the oldest) O(1).
+ */
+
+#ifndef GHOSTLIST_H
+#define GHOSTLIST_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "virtualMemoryTypes.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+class GhostList {
+ public:
+  /**
+   * @return true if page of process is on the list
+   */
+  bool contains(ProcessId process, PageNumber page) const {
+    return _where.contains(Key{process, page});
+  }
+
+  /**
+   * Add page of process as the most recent (or move it there).
+   */
+  void pushFront(ProcessId process, PageNumber page);
+
+  /**
+   * Remove page of process from the list.
+   *
+   * @return false if it was not on the list
+   */
+  bool erase(ProcessId process, PageNumber page);
+
+  /**
+   * Forget the oldest page; the list must not be empty.
+   */
+  void popBack();
+
+  size_t size() const { return _order.size(); }
+  bool empty() const { return _order.empty(); }
+  void clear();
+
+  /**
+   * Save the pages to a snapshot, oldest first.
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * Replace the pages with those saved to a snapshot.
+   */
+  void restore(SnapshotReader& in);
+
+ private:
+  using Key = std::pair<ProcessId, PageNumber>;
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return std::hash<uint64_t>()(key.second * 0x9E3779B97F4A7C15ull ^
+                                   key.first);
+    }
+  };
+
+  std::list<Key> _order;  // most recent first
+  std::unordered_map<Key, std::list<Key>::iterator, KeyHash> _where;
+};
+
+#endif /* GHOSTLIST_H */
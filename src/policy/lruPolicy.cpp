@@ -0,0 +1,86 @@
+#include "lruPolicy.h"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration timeRegistration("TIME", makePolicyOf<LruPolicy>);
+static PolicyRegistration lruRegistration("LRU", makePolicyOf<LruPolicy>);
+
+void LruPolicy::reset(const RAM& ram) {
+  _sentinel = ram.size();
+  _prev.assign(ram.size() + 1, noSuchFrame);
+  _next.assign(ram.size() + 1, noSuchFrame);
+  _prev[_sentinel] = _next[_sentinel] = _sentinel;
+
+  std::vector<FrameNumber> resident;
+  for (FrameNumber f = 0; f < ram.size(); f++)
+    if (ram.mapping(f) != nullptr) resident.push_back(f);
+  std::stable_sort(resident.begin(), resident.end(),
+                   [&ram](FrameNumber a, FrameNumber b) {
+                     return ram[a].timestamp() < ram[b].timestamp();
+                   });
+  for (FrameNumber f : resident) pushBack(f);
+}
+
+FrameNumber LruPolicy::victim(const RAM& ram, PageNumber incoming,
+                              ProcessId owner) {
+  if (owner == noSuchProcess) return _next[_sentinel];
+  for (FrameNumber f = _next[_sentinel]; f != _sentinel; f = _next[f])
+    if (ram[f].process() == owner) return f;
+  return noSuchFrame;
+}
+
+void LruPolicy::olderThan(const RAM& ram, ProcessId process,
+                          EventTime cutoff,
+                          std::vector<FrameNumber>& frames) const {
+  for (FrameNumber f = _next[_sentinel];
+       f != _sentinel && ram[f].timestamp() < cutoff; f = _next[f])
+    if (ram[f].process() == process) frames.push_back(f);
+}
+
+void LruPolicy::loaded(FrameNumber f, const RAM& ram) { pushBack(f); }
+
+void LruPolicy::touched(FrameNumber f, const RAM& ram) {
+  if (_prev[_sentinel] == f) return;  // already most recently used
+  unlink(f);
+  pushBack(f);
+}
+
+void LruPolicy::evicted(FrameNumber f, const RAM& ram) { unlink(f); }
+
+void LruPolicy::save(SnapshotWriter& out) const {
+  std::vector<FrameNumber> order;
+  for (FrameNumber f = _next[_sentinel]; f != _sentinel; f = _next[f])
+    order.push_back(f);
+  out.putArray(order);
+}
+
+void LruPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  std::span<const FrameNumber> order = in.getArray<FrameNumber>();
+  _prev.assign(ram.size() + 1, noSuchFrame);
+  _next.assign(ram.size() + 1, noSuchFrame);
+  _prev[_sentinel] = _next[_sentinel] = _sentinel;
+  for (FrameNumber f : order) {
+    if (f >= _sentinel || _next[f] != noSuchFrame)
+      throw std::runtime_error("bad TIME policy in snapshot");
+    pushBack(f);
+  }
+}
+
+void LruPolicy::unlink(FrameNumber f) {
+  _next[_prev[f]] = _next[f];
+  _prev[_next[f]] = _prev[f];
+  _prev[f] = _next[f] = noSuchFrame;
+}
+
+void LruPolicy::pushBack(FrameNumber f) {
+  FrameNumber last = _prev[_sentinel];
+  _next[last] = f;
+  _prev[f] = last;
+  _next[f] = _sentinel;
+  _prev[_sentinel] = f;
+}
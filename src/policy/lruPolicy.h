@@ -0,0 +1,70 @@
+/**
+ * LruPolicy implements exact least-recently-used replacement (the TIME
+ * command).
+ *
+ * Resident frames are kept on an intrusive doubly-linked list ordered by last
+ * access: the links are indexed by FrameNumber, so touching a frame and
+ * picking the victim are both O(1). The order is the same one the Frame
+ * timestamps give, without scanning RAM for the oldest timestamp.
+ */
+
+#ifndef LRUPOLICY_H
+#define LRUPOLICY_H
+
+#include <vector>
+
+#include "replacementPolicy.h"
+
+class LruPolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "TIME"; }
+
+  /**
+   * Link every mapped Frame, oldest timestamp first.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * @return the least recently used Frame (head of the list); for local
+   * replacement, the least recently used of owner's frames, found by
+   * walking past the older frames of other processes
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  void loaded(FrameNumber f, const RAM& ram) override;
+  void touched(FrameNumber f, const RAM& ram) override;
+  void evicted(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Save the frames in access order, least recently used first.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ protected:
+  /**
+   * Add to frames the frames of process last accessed before cutoff, walking
+   * from the least recently used end of the list.
+   */
+  void olderThan(const RAM& ram, ProcessId process, EventTime cutoff,
+                 std::vector<FrameNumber>& frames) const;
+
+ private:
+  /**
+   * Remove f from the list.
+   */
+  void unlink(FrameNumber f);
+
+  /**
+   * Insert f at the most recently used end of the list.
+   */
+  void pushBack(FrameNumber f);
+
+  // _prev/_next[ram.size()] is the list sentinel
+  std::vector<FrameNumber> _prev;
+  std::vector<FrameNumber> _next;
+  FrameNumber _sentinel{0};
+};
+
+#endif /* LRUPOLICY_H */
@@ -0,0 +1,129 @@
+#include "nextUseIndex.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "temporaryFile.h"
+
+// accesses per block read or written in either pass
+static const size_t blockEntries = 1 << 16;
+
+namespace {
+
+struct AccessKey {
+  PageNumber page;
+  ProcessId process;
+  bool operator==(const AccessKey& other) const {
+    return page == other.page && process == other.process;
+  }
+};
+
+struct AccessKeyHash {
+  size_t operator()(const AccessKey& key) const {
+    return std::hash<PageNumber>()(key.page * 0x9E3779B97F4A7C15ull +
+                                   key.process);
+  }
+};
+
+// closes a temporary file on the way out, unless it was kept (fd -1)
+struct FileCloser {
+  int fd;
+  ~FileCloser() {
+    if (fd >= 0) close(fd);
+  }
+};
+
+[[noreturn]] void fail(const char* what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+void writeAll(int fd, const void* data, size_t size, off_t offset) {
+  const char* bytes = static_cast<const char*>(data);
+  for (size_t done = 0; done < size;) {
+    ssize_t wrote = pwrite(fd, bytes + done, size - done, offset + done);
+    if (wrote < 0 && errno == EINTR) continue;
+    if (wrote < 0) fail("writing the next-use index");
+    done += wrote;
+  }
+}
+
+void readAll(int fd, void* data, size_t size, off_t offset) {
+  char* bytes = static_cast<char*>(data);
+  for (size_t done = 0; done < size;) {
+    ssize_t got = pread(fd, bytes + done, size - done, offset + done);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) fail("reading the next-use index");
+    done += got;
+  }
+}
+
+}  // namespace
+
+NextUseIndex::NextUseIndex(TraceReader& input, const Geometry& geometry) {
+  // pass 1: the key of every access, in trace order
+  FileCloser keys{temporaryFile()};
+  std::vector<AccessKey> block;
+  block.reserve(blockEntries);
+  ProcessId process = 0;
+  TraceCommand cmd;
+  while (input.next(cmd) && cmd.op != TraceOp::QUIT) {
+    if (cmd.op == TraceOp::PROCESS) process = cmd.address;
+    if (cmd.op != TraceOp::READ && cmd.op != TraceOp::WRITE) continue;
+    if (_accesses + block.size() + 1 >= neverUsed)
+      throw std::length_error("NextUseIndex: too many accesses for OPT");
+    block.push_back(AccessKey{getPage(cmd.address, geometry), process});
+    if (block.size() == blockEntries) {
+      writeAll(keys.fd, block.data(), block.size() * sizeof(AccessKey),
+               _accesses * sizeof(AccessKey));
+      _accesses += block.size();
+      block.clear();
+    }
+  }
+  writeAll(keys.fd, block.data(), block.size() * sizeof(AccessKey),
+           _accesses * sizeof(AccessKey));
+  _accesses += block.size();
+
+  // pass 2: backwards, the next use of every access
+  FileCloser index{temporaryFile()};
+  if (ftruncate(index.fd, _accesses * sizeof(EventTime)) < 0)
+    fail("sizing the next-use index");
+  std::unordered_map<AccessKey, EventTime, AccessKeyHash> seen;
+  std::vector<EventTime> next;
+  for (size_t end = _accesses; end > 0;) {
+    size_t start = end > blockEntries ? end - blockEntries : 0;
+    block.resize(end - start);
+    next.resize(end - start);
+    readAll(keys.fd, block.data(), block.size() * sizeof(AccessKey),
+            start * sizeof(AccessKey));
+    for (size_t i = block.size(); i-- > 0;) {
+      auto [last, first] = seen.try_emplace(block[i], start + i + 1);
+      next[i] = first ? neverUsed : last->second;
+      last->second = start + i + 1;
+    }
+    writeAll(index.fd, next.data(), next.size() * sizeof(EventTime),
+             start * sizeof(EventTime));
+    end = start;
+  }
+
+  if (_accesses > 0) {
+    void* mapped = mmap(nullptr, _accesses * sizeof(EventTime), PROT_READ,
+                        MAP_SHARED, index.fd, 0);
+    if (mapped == MAP_FAILED) fail("mapping the next-use index");
+    madvise(mapped, _accesses * sizeof(EventTime), MADV_SEQUENTIAL);
+    _next = static_cast<const EventTime*>(mapped);
+  }
+  std::swap(_fd, index.fd);
+}
+
+NextUseIndex::~NextUseIndex() {
+  if (_next != nullptr)
+    munmap(const_cast<EventTime*>(_next), _accesses * sizeof(EventTime));
+  close(_fd);
+}
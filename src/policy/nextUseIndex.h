@@ -0,0 +1,66 @@
+/**
+ * NextUseIndex records, for every access of a trace, when the same page (of
+ * the same process) is accessed next: the future knowledge OPT replacement
+ * needs.
+ *
+ * Accesses are numbered by the event clock (1 for the first READ/WRITE).
+ * The index is built in two streaming passes through temporary files, so
+ * only the distinct pages, not the trace, have to fit in memory: the first
+ * pass writes the (process, page) of each access to a key file; the second
+ * reads the key file backwards a block at a time, remembering the latest
+ * time each page was seen, and writes each access's next use into the index
+ * file. The index file is then mapped read-only; OPT reads it in trace
+ * order, so the kernel pages it in and out as it goes.
+ */
+
+#ifndef NEXTUSEINDEX_H
+#define NEXTUSEINDEX_H
+
+#include <cstddef>
+#include <memory>
+
+#include "traceReader.h"
+#include "virtualMemoryTypes.h"
+
+/**
+ * The next use of a page that is never accessed again.
+ */
+const EventTime neverUsed = 0xFFFFFFFF;
+
+class NextUseIndex {
+ public:
+  /**
+   * Read the whole trace (up to the end or QUIT), following PROCESS
+   * switches, and build its index.
+   *
+   * @param input the trace; it is consumed
+   * @param geometry splits trace addresses into page and offset
+   * @throw what input.next() throws; std::system_error if a temporary file
+   * cannot be written or mapped; std::length_error if the trace has
+   * neverUsed or more accesses, whose times would not fit an EventTime
+   */
+  NextUseIndex(TraceReader& input, const Geometry& geometry);
+  ~NextUseIndex();
+  NextUseIndex(const NextUseIndex&) = delete;
+  NextUseIndex& operator=(const NextUseIndex&) = delete;
+
+  /**
+   * @return the time of the next access to the page accessed at time now;
+   * neverUsed if there is none, or now is not an access of the trace
+   */
+  EventTime operator[](EventTime now) const {
+    return (now == 0 || now > _accesses) ? neverUsed : _next[now - 1];
+  }
+
+  /**
+   * @return the number of accesses in the trace
+   */
+  size_t accesses() const { return _accesses; }
+
+ private:
+  int _fd{-1};
+  const EventTime* _next{nullptr};  // mapped; entry t - 1 for time t
+  size_t _accesses{0};
+};
+
+#endif /* NEXTUSEINDEX_H */
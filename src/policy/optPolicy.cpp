@@ -0,0 +1,67 @@
+#include "optPolicy.h"
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("OPT", OptPolicy::make);
+
+// the index installed for OptPolicy::make
+static std::shared_ptr<const NextUseIndex>& installedIndex() {
+  static std::shared_ptr<const NextUseIndex> index;
+  return index;
+}
+
+void OptPolicy::useIndex(std::shared_ptr<const NextUseIndex> index) {
+  installedIndex() = std::move(index);
+}
+
+std::unique_ptr<ReplacementPolicy> OptPolicy::make() {
+  if (!installedIndex()) return nullptr;
+  return std::make_unique<OptPolicy>(installedIndex());
+}
+
+void OptPolicy::reset(const RAM& ram) {
+  _byNextUse.clear();
+  _nextUse.assign(ram.size(), neverUsed);
+  _ordered.assign(ram.size(), false);
+  for (FrameNumber f = 0; f < ram.size(); f++)
+    if (ram.mapping(f) != nullptr) touched(f, ram);
+}
+
+FrameNumber OptPolicy::victim(const RAM& ram, PageNumber incoming,
+                              ProcessId owner) {
+  for (auto it = _byNextUse.rbegin(); it != _byNextUse.rend(); ++it) {
+    if (owner != noSuchProcess && ram[it->second].process() != owner)
+      continue;
+    if (it->first == neverUsed) _neverUsedVictims++;
+    return it->second;
+  }
+  return noSuchFrame;
+}
+
+void OptPolicy::touched(FrameNumber f, const RAM& ram) {
+  remove(f);
+  _nextUse[f] = (*_index)[ram[f].timestamp()];
+  _byNextUse.insert({_nextUse[f], f});
+  _ordered[f] = true;
+}
+
+void OptPolicy::evicted(FrameNumber f, const RAM& ram) { remove(f); }
+
+void OptPolicy::remove(FrameNumber f) {
+  if (!_ordered[f]) return;
+  _byNextUse.erase({_nextUse[f], f});
+  _ordered[f] = false;
+}
+
+std::vector<PolicyCounter> OptPolicy::counters() const {
+  return {{"never used", _neverUsedVictims}};
+}
+
+void OptPolicy::save(SnapshotWriter& out) const {
+  out.put(_neverUsedVictims);
+}
+
+void OptPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _neverUsedVictims = in.get();
+}
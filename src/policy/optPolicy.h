@@ -0,0 +1,86 @@
+/**
+ * OptPolicy implements Belady's optimal replacement (the OPT command): the
+ * victim is the Frame whose page is next accessed furthest in the future,
+ * or never again.
+ *
+ * The future comes from a NextUseIndex of the whole trace, built before the
+ * run (vmSimulator -O) and installed with OptPolicy::useIndex(); OPT cannot
+ * be selected without one. The index is looked up by the frame's timestamp,
+ * which is the event clock of its last access, so OPT can also be selected
+ * in the middle of a run.
+ *
+ * Resident frames are kept in a set ordered by next use, so both touching a
+ * frame and finding the victim are O(log frames); unlike the other policies,
+ * touched() is not O(1).
+ */
+
+#ifndef OPTPOLICY_H
+#define OPTPOLICY_H
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "nextUseIndex.h"
+#include "replacementPolicy.h"
+
+class OptPolicy : public ReplacementPolicy {
+ public:
+  /**
+   * Install the index every OptPolicy made from now on uses.
+   */
+  static void useIndex(std::shared_ptr<const NextUseIndex> index);
+
+  /**
+   * Factory for the registry.
+   *
+   * @return a new OptPolicy; nullptr if no index is installed
+   */
+  static std::unique_ptr<ReplacementPolicy> make();
+
+  explicit OptPolicy(std::shared_ptr<const NextUseIndex> index)
+      : _index(std::move(index)) {}
+
+  const char* name() const override { return "OPT"; }
+
+  /**
+   * Order every mapped Frame by the next use of its last access.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * @return the Frame used furthest in the future; for local replacement,
+   * the one of owner's frames used furthest in the future
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  /**
+   * Reorder f by the next use of the access just made.
+   */
+  void touched(FrameNumber f, const RAM& ram) override;
+  void evicted(FrameNumber f, const RAM& ram) override;
+
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the counter; reset() rebuilds the order from the timestamps.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  /**
+   * Remove f from the order, if it is in it.
+   */
+  void remove(FrameNumber f);
+
+  std::shared_ptr<const NextUseIndex> _index;
+  std::set<std::pair<EventTime, FrameNumber>> _byNextUse;
+  std::vector<EventTime> _nextUse;  // of each frame in _byNextUse
+  std::vector<bool> _ordered;       // is the frame in _byNextUse?
+  unsigned long _neverUsedVictims{0};
+};
+
+#endif /* OPTPOLICY_H */
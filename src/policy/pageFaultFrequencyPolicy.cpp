@@ -0,0 +1,53 @@
+#include "pageFaultFrequencyPolicy.h"
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration(
+    "PFF", makePolicyOf<PageFaultFrequencyPolicy>);
+
+static EventTime thresholdEvents = 100;
+
+void PageFaultFrequencyPolicy::threshold(EventTime events) {
+  thresholdEvents = events;
+}
+
+void PageFaultFrequencyPolicy::release(const RAM& ram, ProcessId process,
+                                       EventTime now,
+                                       std::vector<FrameNumber>& frames) {
+  EventTime& lastFault = _lastFault[process];
+  EventTime previous = lastFault;
+  lastFault = now;
+  if (previous == 0 || now - previous <= thresholdEvents) return;
+  olderThan(ram, process, previous, frames);
+  _shrinks++;
+  _released += frames.size();
+}
+
+std::vector<PolicyCounter> PageFaultFrequencyPolicy::counters() const {
+  return {{"shrinks", _shrinks}, {"released", _released}};
+}
+
+void PageFaultFrequencyPolicy::save(SnapshotWriter& out) const {
+  LruPolicy::save(out);
+  out.put(thresholdEvents);
+  out.put(_lastFault.size());
+  for (const auto& [process, time] : _lastFault) {
+    out.put(process);
+    out.put(time);
+  }
+  out.put(_shrinks);
+  out.put(_released);
+}
+
+void PageFaultFrequencyPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  LruPolicy::restore(in, ram);
+  in.expect(thresholdEvents, "PFF threshold");
+  _lastFault.clear();
+  for (uint64_t n = in.get(); n-- > 0;) {
+    ProcessId process = in.get();
+    _lastFault[process] = in.get();
+  }
+  _shrinks = in.get();
+  _released = in.get();
+}
@@ -0,0 +1,52 @@
+/**
+ * PageFaultFrequencyPolicy implements page-fault-frequency replacement (the
+ * PFF command): a process's resident set grows while it faults often and
+ * shrinks when it faults rarely.
+ *
+ * On each fault the time since the process's previous fault is compared
+ * with a threshold. Within it, the process faults too often: it keeps all
+ * its frames and gains the one the fault loads. Beyond it, the process has
+ * more memory than it needs: it gives back every frame it has not touched
+ * since its previous fault. When RAM is full the victim is the least
+ * recently used frame, as for TIME.
+ *
+ * The threshold is shared by all PFF policies; set it with -F.
+ */
+
+#ifndef PAGEFAULTFREQUENCYPOLICY_H
+#define PAGEFAULTFREQUENCYPOLICY_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "lruPolicy.h"
+
+class PageFaultFrequencyPolicy : public LruPolicy {
+ public:
+  /**
+   * Set the threshold of every PageFaultFrequencyPolicy: the events between
+   * faults above which a process shrinks (default 100).
+   */
+  static void threshold(EventTime events);
+
+  const char* name() const override { return "PFF"; }
+
+  /**
+   * Release the faulting process's frames not touched since its previous
+   * fault, if that was more than the threshold before now.
+   */
+  void release(const RAM& ram, ProcessId process, EventTime now,
+               std::vector<FrameNumber>& frames) override;
+
+  std::vector<PolicyCounter> counters() const override;
+
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  std::unordered_map<ProcessId, EventTime> _lastFault;
+  unsigned long _shrinks{0};
+  unsigned long _released{0};
+};
+
+#endif /* PAGEFAULTFREQUENCYPOLICY_H */
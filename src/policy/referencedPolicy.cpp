@@ -0,0 +1,81 @@
+#include "referencedPolicy.h"
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("REF",
+                                       makePolicyOf<ReferencedPolicy>);
+
+ReferencedPolicy::Resident ReferencedPolicy::resident(const RAM& ram,
+                                                      FrameNumber f) {
+  return {ram[f].process(), ram[f].page(), f};
+}
+
+FrameNumber ReferencedPolicy::first(const std::set<Resident>& set,
+                                    ProcessId owner) {
+  auto found = set.begin();
+  if (owner != noSuchProcess) {
+    found = set.lower_bound({owner, 0, 0});
+    if (found != set.end() && std::get<0>(*found) != owner) found = set.end();
+  }
+  return (found == set.end()) ? noSuchFrame : std::get<2>(*found);
+}
+
+void ReferencedPolicy::reset(const RAM& ram) {
+  _resident.clear();
+  _unreferenced.clear();
+  _isUnreferenced.assign(ram.size(), false);
+  for (FrameNumber f = 0; f < ram.size(); f++) {
+    PTE* pte = ram.mapping(f);
+    if (pte == nullptr) continue;
+    _resident.insert(resident(ram, f));
+    if (!pte->referenced()) {
+      _unreferenced.insert(resident(ram, f));
+      _isUnreferenced[f] = true;
+    }
+  }
+}
+
+FrameNumber ReferencedPolicy::victim(const RAM& ram, PageNumber incoming,
+                                     ProcessId owner) {
+  FrameNumber f = first(_unreferenced, owner);
+  if (f != noSuchFrame) return f;
+  f = first(_resident, owner);
+  if (f != noSuchFrame) _allReferenced++;
+  return f;
+}
+
+void ReferencedPolicy::loaded(FrameNumber f, const RAM& ram) {
+  _resident.insert(resident(ram, f));
+  _unreferenced.insert(resident(ram, f));
+  _isUnreferenced[f] = true;
+}
+
+void ReferencedPolicy::touched(FrameNumber f, const RAM& ram) {
+  if (!_isUnreferenced[f]) return;
+  _unreferenced.erase(resident(ram, f));
+  _isUnreferenced[f] = false;
+}
+
+void ReferencedPolicy::evicted(FrameNumber f, const RAM& ram) {
+  _resident.erase(resident(ram, f));
+  if (_isUnreferenced[f]) _unreferenced.erase(resident(ram, f));
+  _isUnreferenced[f] = false;
+}
+
+void ReferencedPolicy::referencesCleared(const RAM& ram) {
+  _unreferenced = _resident;
+  for (const Resident& r : _resident) _isUnreferenced[std::get<2>(r)] = true;
+}
+
+std::vector<PolicyCounter> ReferencedPolicy::counters() const {
+  return {{"all referenced", _allReferenced}};
+}
+
+void ReferencedPolicy::save(SnapshotWriter& out) const {
+  out.put(_allReferenced);
+}
+
+void ReferencedPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _allReferenced = in.get();
+}
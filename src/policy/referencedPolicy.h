@@ -0,0 +1,80 @@
+/**
+ * ReferencedPolicy implements replacement by the PTE referenced bit (the REF
+ * command).
+ *
+ * The victim is the Frame holding the lowest numbered resident page whose
+ * referenced bit is clear; if every resident page has been referenced, it is
+ * the Frame holding the lowest numbered resident page. Pages are ordered by
+ * process first, so for local replacement the victim is the lowest of the
+ * process's own pages.
+ *
+ * Resident pages are kept in ordered sets so the victim is found in
+ * O(log frames) instead of by sweeping the whole PageTable.
+ */
+
+#ifndef REFERENCEDPOLICY_H
+#define REFERENCEDPOLICY_H
+
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "replacementPolicy.h"
+
+class ReferencedPolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "REF"; }
+
+  /**
+   * Rebuild the resident and unreferenced sets from RAM and the PTE that map
+   * its frames.
+   */
+  void reset(const RAM& ram) override;
+
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  void loaded(FrameNumber f, const RAM& ram) override;
+  void touched(FrameNumber f, const RAM& ram) override;
+  void evicted(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Every resident page is now unreferenced.
+   */
+  void referencesCleared(const RAM& ram) override;
+
+  /**
+   * Victims chosen when every resident page was referenced.
+   */
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the counter; reset() rebuilds the sets from RAM and the PTE.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  using Resident = std::tuple<ProcessId, PageNumber, FrameNumber>;
+
+  /**
+   * The set entry for the page in frame f.
+   */
+  static Resident resident(const RAM& ram, FrameNumber f);
+
+  /**
+   * The first entry of set owned by owner (any entry for noSuchProcess).
+   *
+   * @return its frame; noSuchFrame if there is none
+   */
+  static FrameNumber first(const std::set<Resident>& set, ProcessId owner);
+
+  std::set<Resident> _resident;
+  std::set<Resident> _unreferenced;
+  // _isUnreferenced[f] is true iff f's page is in _unreferenced; it keeps
+  // touched() O(1) for pages that are already referenced
+  std::vector<bool> _isUnreferenced;
+  unsigned long _allReferenced{0};
+};
+
+#endif /* REFERENCEDPOLICY_H */
@@ -0,0 +1,26 @@
+#include "replacementPolicy.h"
+
+#include <map>
+
+#include "ram.h"
+
+// Function-local so registrations from other translation units can run
+// during static initialization in any order.
+static std::map<std::string, PolicyFactory>& registry() {
+  static std::map<std::string, PolicyFactory> policies;
+  return policies;
+}
+
+PolicyRegistration::PolicyRegistration(const std::string& name,
+                                       PolicyFactory factory) {
+  registry()[name] = factory;
+}
+
+std::unique_ptr<ReplacementPolicy> makePolicy(const std::string& name,
+                                              const RAM& ram) {
+  auto found = registry().find(name);
+  if (found == registry().end()) return nullptr;
+  std::unique_ptr<ReplacementPolicy> policy = found->second();
+  if (policy) policy->reset(ram);
+  return policy;
+}
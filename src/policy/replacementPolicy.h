@@ -0,0 +1,156 @@
+/**
+ * ReplacementPolicy is the interface every page replacement algorithm
+ * implements.
+ *
+ * RAM::load asks the active policy for a victim only when there is no free
+ * Frame; before that, on every fault, the policy may release frames. The
+ * command loop tells the policy about every access, so each policy can keep
+ * whatever bookkeeping makes its victim selection cheap.
+ *
+ * Policies register themselves by name (see PolicyRegistration); the name is
+ * also the trace command that selects the policy, so adding a policy is just
+ * adding a .cpp file to this module.
+ */
+
+#ifndef REPLACEMENTPOLICY_H
+#define REPLACEMENTPOLICY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "statistics.h"
+#include "virtualMemoryTypes.h"
+
+class RAM;
+class SnapshotReader;
+class SnapshotWriter;
+
+class ReplacementPolicy {
+ public:
+  virtual ~ReplacementPolicy() = default;
+
+  /**
+   * The name of the policy; the same as the command that selects it.
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * Rebuild the policy's bookkeeping from the current content of RAM.
+   *
+   * Called when the policy is selected, which may be in the middle of a run.
+   *
+   * @param ram the frames the policy manages
+   */
+  virtual void reset(const RAM& ram) = 0;
+
+  /**
+   * Choose the Frame to evict. Only called when RAM has no free Frame.
+   *
+   * @param ram the frames the policy manages
+   * @param incoming the page that is about to be loaded
+   * @param owner the process whose frames to choose from (local
+   * replacement); noSuchProcess to choose from all frames
+   * @return FrameNumber of the victim; noSuchFrame if owner has no frames
+   */
+  virtual FrameNumber victim(const RAM& ram, PageNumber incoming,
+                             ProcessId owner) = 0;
+
+  /**
+   * A page fault of process is about to be served at time now. A policy
+   * that sizes each process's resident set (WS, PFF) adds the frames to take
+   * away from it to frames; they are evicted and become free before the
+   * page is loaded. Most policies release nothing.
+   *
+   * @param ram the frames the policy manages
+   * @param process the faulting process
+   * @param now the event clock of the faulting access
+   * @param frames empty; filled with the frames to release
+   */
+  virtual void release(const RAM& ram, ProcessId process, EventTime now,
+                       std::vector<FrameNumber>& frames) {}
+
+  /**
+   * Page p of process is about to be loaded: called before every load that
+   * chooses its frame, so before victim() when no frame is free.
+   */
+  virtual void loading(ProcessId process, PageNumber p, const RAM& ram) {}
+
+  /**
+   * A page has just been loaded into Frame f.
+   */
+  virtual void loaded(FrameNumber f, const RAM& ram) {}
+
+  /**
+   * The page in Frame f has just been accessed. This is the hot path; it runs
+   * once per READ/WRITE and must stay O(1).
+   */
+  virtual void touched(FrameNumber f, const RAM& ram) {}
+
+  /**
+   * The page in Frame f is about to be evicted; the Frame still holds it.
+   */
+  virtual void evicted(FrameNumber f, const RAM& ram) {}
+
+  /**
+   * The referenced bits of all PTE were just cleared.
+   */
+  virtual void referencesCleared(const RAM& ram) {}
+
+  /**
+   * The policy's own counters, for the end of run summary. Counting must
+   * stay out of touched().
+   */
+  virtual std::vector<PolicyCounter> counters() const { return {}; }
+
+  /**
+   * Save to a snapshot what the policy keeps that reset() cannot rebuild
+   * from RAM: the order of its lists, a clock hand, its counters.
+   */
+  virtual void save(SnapshotWriter& out) const {}
+
+  /**
+   * Restore what save() saved, into a policy just made (and so reset) for
+   * the restored RAM.
+   *
+   * @throw std::runtime_error if the snapshot is bad
+   */
+  virtual void restore(SnapshotReader& in, const RAM& ram) {}
+};
+
+/**
+ * Factory signature used by the policy registry. A factory may return
+ * nullptr if the policy cannot run (e.g. OPT without its index).
+ */
+using PolicyFactory = std::unique_ptr<ReplacementPolicy> (*)();
+
+/**
+ * Register a policy under the given name. Instantiate one of these at
+ * namespace scope in the policy's .cpp file:
+ *
+ *   static PolicyRegistration registration("CLOCK", makePolicyOf<ClockPolicy>);
+ */
+struct PolicyRegistration {
+  PolicyRegistration(const std::string& name, PolicyFactory factory);
+};
+
+/**
+ * Generic factory for PolicyRegistration.
+ */
+template <typename Policy>
+std::unique_ptr<ReplacementPolicy> makePolicyOf() {
+  return std::make_unique<Policy>();
+}
+
+/**
+ * Build the policy registered under name and reset it to the content of RAM.
+ *
+ * @param name the policy (command) name, e.g. "TIME"
+ * @param ram the frames the new policy will manage
+ * @return the new policy; nullptr if no policy has that name or it cannot
+ * run
+ */
+std::unique_ptr<ReplacementPolicy> makePolicy(const std::string& name,
+                                              const RAM& ram);
+
+#endif /* REPLACEMENTPOLICY_H */
@@ -0,0 +1,85 @@
+#include "twoQueuePolicy.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("2Q", makePolicyOf<TwoQueuePolicy>);
+
+void TwoQueuePolicy::reset(const RAM& ram) {
+  _kin = std::max<size_t>(ram.size() / 4, 1);
+  _kout = std::max<size_t>(ram.size() / 2, 1);
+  _lists.reset(ram.size(), 2);
+  _a1out.clear();
+  _hotPage = noSuchPage;
+
+  std::vector<FrameNumber> resident;
+  for (FrameNumber f = 0; f < ram.size(); f++)
+    if (ram.mapping(f) != nullptr) resident.push_back(f);
+  std::stable_sort(resident.begin(), resident.end(),
+                   [&ram](FrameNumber a, FrameNumber b) {
+                     return ram[a].timestamp() < ram[b].timestamp();
+                   });
+  for (FrameNumber f : resident) _lists.pushBack(A1in, f);
+}
+
+void TwoQueuePolicy::loading(ProcessId process, PageNumber p,
+                             const RAM& ram) {
+  _hotPage = noSuchPage;
+  if (!_a1out.erase(process, p)) return;
+  _ghostHits++;
+  _hotProcess = process;
+  _hotPage = p;
+}
+
+FrameNumber TwoQueuePolicy::victim(const RAM& ram, PageNumber incoming,
+                                   ProcessId owner) {
+  bool fromA1in = _lists.size(A1in) > _kin || _lists.size(Am) == 0;
+  FrameNumber f = oldest(fromA1in ? A1in : Am, ram, owner);
+  if (f == noSuchFrame) f = oldest(fromA1in ? Am : A1in, ram, owner);
+  return f;
+}
+
+FrameNumber TwoQueuePolicy::oldest(List list, const RAM& ram,
+                                   ProcessId owner) const {
+  for (FrameNumber f = _lists.front(list); f != noSuchFrame;
+       f = _lists.next(f))
+    if (owner == noSuchProcess || ram[f].process() == owner) return f;
+  return noSuchFrame;
+}
+
+void TwoQueuePolicy::loaded(FrameNumber f, const RAM& ram) {
+  bool hot = ram[f].page() == _hotPage && ram[f].process() == _hotProcess;
+  _lists.pushBack(hot ? Am : A1in, f);
+  _hotPage = noSuchPage;
+}
+
+void TwoQueuePolicy::touched(FrameNumber f, const RAM& ram) {
+  if (_lists.list(f) == Am) _lists.pushBack(Am, f);
+}
+
+void TwoQueuePolicy::evicted(FrameNumber f, const RAM& ram) {
+  if (_lists.list(f) == A1in) {
+    _a1out.pushFront(ram[f].process(), ram[f].page());
+    if (_a1out.size() > _kout) _a1out.popBack();
+  }
+  _lists.remove(f);
+}
+
+std::vector<PolicyCounter> TwoQueuePolicy::counters() const {
+  return {{"A1out hits", _ghostHits}};
+}
+
+void TwoQueuePolicy::save(SnapshotWriter& out) const {
+  _lists.save(out);
+  _a1out.save(out);
+  out.put(_ghostHits);
+}
+
+void TwoQueuePolicy::restore(SnapshotReader& in, const RAM& ram) {
+  _lists.restore(in);
+  _a1out.restore(in);
+  _ghostHits = in.get();
+}
@@ -0,0 +1,95 @@
+/**
+ * TwoQueuePolicy implements the full version of 2Q (the 2Q command), after
+ * Johnson and Shasha, "2Q: A Low Overhead High Performance Buffer Management
+ * Replacement Algorithm" (VLDB 1994).
+ *
+ * A page loaded for the first time goes on A1in, a FIFO of at most Kin
+ * (a quarter of RAM) frames; using it again there does not move it. When it
+ * leaves A1in, the page is remembered on the ghost list A1out (at most Kout,
+ * half of RAM, pages). Only a page that faults again while on A1out is taken
+ * to be hot, and loaded onto Am, an LRU list that holds the rest of RAM. Pages
+ * used once, as in a scan, pass through A1in without disturbing Am.
+ *
+ * Both resident lists are linked by FrameNumber (FrameLists) and the ghosts
+ * hashed by page (GhostList), so every operation is O(1).
+ */
+
+#ifndef TWOQUEUEPOLICY_H
+#define TWOQUEUEPOLICY_H
+
+#include "frameLists.h"
+#include "ghostList.h"
+#include "replacementPolicy.h"
+
+class TwoQueuePolicy : public ReplacementPolicy {
+ public:
+  const char* name() const override { return "2Q"; }
+
+  /**
+   * Put every mapped Frame on A1in, oldest timestamp first, and forget
+   * A1out.
+   */
+  void reset(const RAM& ram) override;
+
+  /**
+   * If the page is on A1out, take it off: it is hot and will go on Am.
+   */
+  void loading(ProcessId process, PageNumber p, const RAM& ram) override;
+
+  /**
+   * @return the oldest frame of A1in if A1in is over Kin (or Am is empty),
+   * else the least recently used of Am; for local replacement, the oldest
+   * of owner's frames in that order
+   */
+  FrameNumber victim(const RAM& ram, PageNumber incoming,
+                     ProcessId owner) override;
+
+  /**
+   * Put a hot page at the back of Am, any other at the back of A1in.
+   */
+  void loaded(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Move a page on Am to its back; pages on A1in stay where they are.
+   */
+  void touched(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Remember a page leaving A1in on A1out, forgetting the oldest ghost past
+   * Kout.
+   */
+  void evicted(FrameNumber f, const RAM& ram) override;
+
+  /**
+   * Faults on pages found in A1out.
+   */
+  std::vector<PolicyCounter> counters() const override;
+
+  /**
+   * Save the three lists and the counter.
+   */
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  enum List : unsigned { A1in, Am };
+
+  /**
+   * The oldest frame of list that belongs to owner (any process for
+   * noSuchProcess); noSuchFrame if there is none.
+   */
+  FrameNumber oldest(List list, const RAM& ram, ProcessId owner) const;
+
+  FrameLists _lists;
+  GhostList _a1out;
+  size_t _kin{1};   // the size A1in may grow to before it gives up frames
+  size_t _kout{1};  // the most pages A1out remembers
+
+  // the page being loaded, if it was found on A1out
+  ProcessId _hotProcess{noSuchProcess};
+  PageNumber _hotPage{noSuchPage};
+
+  unsigned long _ghostHits{0};
+};
+
+#endif /* TWOQUEUEPOLICY_H */
@@ -0,0 +1,34 @@
+#include "workingSetPolicy.h"
+
+#include "ram.h"
+#include "snapshot.h"
+
+static PolicyRegistration registration("WS", makePolicyOf<WorkingSetPolicy>);
+
+static EventTime windowEvents = 1000;
+
+void WorkingSetPolicy::window(EventTime events) { windowEvents = events; }
+
+void WorkingSetPolicy::release(const RAM& ram, ProcessId process,
+                               EventTime now,
+                               std::vector<FrameNumber>& frames) {
+  if (now <= windowEvents) return;
+  olderThan(ram, process, now - windowEvents, frames);
+  _released += frames.size();
+}
+
+std::vector<PolicyCounter> WorkingSetPolicy::counters() const {
+  return {{"released", _released}};
+}
+
+void WorkingSetPolicy::save(SnapshotWriter& out) const {
+  LruPolicy::save(out);
+  out.put(windowEvents);
+  out.put(_released);
+}
+
+void WorkingSetPolicy::restore(SnapshotReader& in, const RAM& ram) {
+  LruPolicy::restore(in, ram);
+  in.expect(windowEvents, "WS window");
+  _released = in.get();
+}
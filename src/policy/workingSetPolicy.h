@@ -0,0 +1,48 @@
+/**
+ * WorkingSetPolicy implements working-set replacement (the WS command): a
+ * process keeps only the pages it accessed within the last window events of
+ * the event clock.
+ *
+ * On each fault the faulting process gives back every frame it has not
+ * touched within the window, so its resident set grows and shrinks with its
+ * working set and the freed frames go to whoever faults next. When RAM is
+ * still full (the working sets do not fit) the victim is the least recently
+ * used frame, as for TIME; the policy is an LruPolicy whose list, oldest
+ * first, also finds the frames outside the window without a scan.
+ *
+ * The window is shared by all WS policies; set it with -W.
+ */
+
+#ifndef WORKINGSETPOLICY_H
+#define WORKINGSETPOLICY_H
+
+#include <vector>
+
+#include "lruPolicy.h"
+
+class WorkingSetPolicy : public LruPolicy {
+ public:
+  /**
+   * Set the window of every WorkingSetPolicy, in events (default 1000).
+   */
+  static void window(EventTime events);
+
+  const char* name() const override { return "WS"; }
+
+  /**
+   * Release the faulting process's frames last accessed more than the
+   * window before now.
+   */
+  void release(const RAM& ram, ProcessId process, EventTime now,
+               std::vector<FrameNumber>& frames) override;
+
+  std::vector<PolicyCounter> counters() const override;
+
+  void save(SnapshotWriter& out) const override;
+  void restore(SnapshotReader& in, const RAM& ram) override;
+
+ private:
+  unsigned long _released{0};
+};
+
+#endif /* WORKINGSETPOLICY_H */
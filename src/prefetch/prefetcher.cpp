@@ -0,0 +1,236 @@
+#include "prefetcher.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include "snapshot.h"
+
+namespace {
+
+/**
+ * Save a map of plain per-process state as one array, sorted by process so
+ * the same state always makes the same snapshot.
+ */
+template <typename State>
+void saveStreams(SnapshotWriter& out,
+                 const std::unordered_map<ProcessId, State>& streams) {
+  struct Entry {
+    ProcessId process;
+    State state;
+  };
+  std::vector<Entry> entries;
+  for (const auto& [process, state] : streams)
+    entries.push_back(Entry{process, state});
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.process < b.process;
+            });
+  out.putArray(entries);
+}
+
+template <typename State>
+void restoreStreams(SnapshotReader& in,
+                    std::unordered_map<ProcessId, State>& streams) {
+  struct Entry {
+    ProcessId process;
+    State state;
+  };
+  streams.clear();
+  for (const Entry& entry : in.getArray<Entry>())
+    streams[entry.process] = entry.state;
+}
+
+class Sequential : public Prefetcher {
+ public:
+  explicit Sequential(unsigned depth) : Prefetcher(depth) {}
+
+  const char* name() const override { return "seq"; }
+
+  void predict(ProcessId process, PageNumber page, bool hit,
+               std::vector<PageNumber>& pages) override {
+    Stream& s = _streams[process];
+    if (hit) {
+      s.last = page;
+      // read the next window once the process is halfway through this one
+      if (page >= s.end || s.end - page > s.window / 2) return;
+    } else {
+      bool sequential =
+          s.last != noSuchPage && (page == s.last + 1 || page == s.end);
+      s.last = page;
+      s.end = page + 1;
+      if (!sequential) {
+        s.window = 0;
+        return;
+      }
+    }
+    s.window = s.window ? std::min(2 * s.window, _depth)
+                        : std::min(firstWindow, _depth);
+    for (unsigned i = 0; i < s.window; i++) pages.push_back(s.end + i);
+    s.end += s.window;
+  }
+
+  void forget(ProcessId process) override { _streams.erase(process); }
+
+  void save(SnapshotWriter& out) const override { saveStreams(out, _streams); }
+
+  void restore(SnapshotReader& in) override { restoreStreams(in, _streams); }
+
+ private:
+  static constexpr unsigned firstWindow = 4;
+
+  struct Stream {
+    PageNumber last{noSuchPage};  // the last page faulted on or hit
+    PageNumber end{0};            // one past the last page read ahead
+    unsigned window{0};           // pages read ahead at a time; 0 for none
+  };
+
+  std::unordered_map<ProcessId, Stream> _streams;
+};
+
+class Strided : public Prefetcher {
+ public:
+  explicit Strided(unsigned depth) : Prefetcher(depth) {}
+
+  const char* name() const override { return "stride"; }
+
+  void predict(ProcessId process, PageNumber page, bool hit,
+               std::vector<PageNumber>& pages) override {
+    Stream& s = _streams[process];
+    if (s.last != noSuchPage) {
+      int64_t stride = int64_t(page - s.last);
+      if (stride != 0 && stride == s.stride) {
+        s.confidence = std::min(s.confidence + 1, _depth);
+      } else {
+        s.stride = stride;
+        s.confidence = 0;
+      }
+    }
+    s.last = page;
+    unsigned degree = std::min(2 * s.confidence, _depth);
+    for (unsigned k = 1; k <= degree; k++)
+      pages.push_back(page + PageNumber(k * s.stride));
+  }
+
+  void forget(ProcessId process) override { _streams.erase(process); }
+
+  void save(SnapshotWriter& out) const override { saveStreams(out, _streams); }
+
+  void restore(SnapshotReader& in) override { restoreStreams(in, _streams); }
+
+ private:
+  struct Stream {
+    PageNumber last{noSuchPage};
+    int64_t stride{0};
+    unsigned confidence{0};  // times in a row the stride repeated
+  };
+
+  std::unordered_map<ProcessId, Stream> _streams;
+};
+
+class Markov : public Prefetcher {
+ public:
+  explicit Markov(unsigned depth) : Prefetcher(depth) {}
+
+  const char* name() const override { return "markov"; }
+
+  void predict(ProcessId process, PageNumber page, bool hit,
+               std::vector<PageNumber>& pages) override {
+    History& h = _histories[process];
+    if (h.last != noSuchPage && h.last != page) {
+      // a bounded table: when it fills, it starts over
+      if (h.table.size() >= maxPages && !h.table.contains(h.last))
+        h.table.clear();
+      Successors& next = h.table[h.last];
+      auto found = std::find_if(next.begin(), next.end(),
+                                [page](const Successor& s) {
+                                  return s.page == page;
+                                });
+      Successor seen{page, 1};
+      if (found != next.end())
+        seen.count = std::min(found->count + 1, 255);
+      else
+        found = next.end() - 1;
+      // most recent first
+      std::move_backward(next.begin(), found, found + 1);
+      next[0] = seen;
+    }
+    h.last = page;
+    auto found = h.table.find(page);
+    if (found == h.table.end()) return;
+    unsigned n = 0;
+    for (const Successor& s : found->second)
+      if (s.count >= minCount && n++ < _depth) pages.push_back(s.page);
+  }
+
+  void forget(ProcessId process) override { _histories.erase(process); }
+
+  // each process: its number and last page, then its table as an array
+  void save(SnapshotWriter& out) const override {
+    std::vector<ProcessId> processes;
+    for (const auto& entry : _histories) processes.push_back(entry.first);
+    std::sort(processes.begin(), processes.end());
+    out.put(processes.size());
+    for (ProcessId process : processes) {
+      const History& h = _histories.at(process);
+      out.put(process);
+      out.put(h.last);
+      std::vector<Entry> table;
+      for (const auto& [page, next] : h.table)
+        table.push_back(Entry{page, next});
+      std::sort(table.begin(), table.end(),
+                [](const Entry& a, const Entry& b) { return a.page < b.page; });
+      out.putArray(table);
+    }
+  }
+
+  void restore(SnapshotReader& in) override {
+    _histories.clear();
+    for (uint64_t n = in.get(); n-- > 0;) {
+      History& h = _histories[in.get()];
+      h.last = in.get();
+      for (const Entry& entry : in.getArray<Entry>())
+        h.table[entry.page] = entry.next;
+    }
+  }
+
+ private:
+  static constexpr size_t width = 4;  // successors kept per page
+  static constexpr int minCount = 2;  // times seen before it is predicted
+  static constexpr size_t maxPages = 1 << 20;  // pages kept per process
+
+  struct Successor {
+    PageNumber page{noSuchPage};
+    int count{0};
+  };
+
+  using Successors = std::array<Successor, width>;
+
+  struct Entry {
+    PageNumber page;
+    Successors next;
+  };
+
+  struct History {
+    PageNumber last{noSuchPage};
+    std::unordered_map<PageNumber, Successors> table;
+  };
+
+  std::unordered_map<ProcessId, History> _histories;
+};
+
+}  // namespace
+
+std::unique_ptr<Prefetcher> Prefetcher::make(const std::string& kind,
+                                             unsigned depth) {
+  if (kind == "seq") return std::make_unique<Sequential>(depth);
+  if (kind == "stride") return std::make_unique<Strided>(depth);
+  if (kind == "markov") return std::make_unique<Markov>(depth);
+  return nullptr;
+}
+
+const std::vector<std::string>& Prefetcher::kinds() {
+  static const std::vector<std::string> names = {"seq", "stride", "markov"};
+  return names;
+}
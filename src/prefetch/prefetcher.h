@@ -0,0 +1,95 @@
+/**
+ * Prefetcher is the interface of the page prefetchers, which predict the
+ * pages a process is about to fault on so the MMU can load them ahead of
+ * demand.
+ *
+ * The MMU asks the prefetcher on every page fault, and on the first access
+ * to each prefetched page (a prefetch hit: the fault that the prefetch
+ * saved), so a prefetcher sees the stream it predicted well go on instead
+ * of losing sight of it. Each kind predicts differently:
+ *
+ *   seq     sequential read-ahead: once two faults fall on consecutive
+ *           pages, load the pages after the second, in a window that
+ *           doubles (up to the depth) each time the process gets halfway
+ *           through it; a fault off the stream closes the window
+ *   stride  a stride detector: once the faults of a process have stepped
+ *           by the same number of pages twice in a row, load the next
+ *           pages at that stride, more of them the longer it holds (up to
+ *           the depth)
+ *   markov  a correlation (Markov) predictor: remember, for each page, the
+ *           last few pages the fault after it went to, and load those seen
+ *           more than once when the page faults again
+ *
+ * The MMU skips predicted pages that are present or past the end of the
+ * page table, so a prefetcher need not know what is in RAM.
+ */
+
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "virtualMemoryTypes.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+class Prefetcher {
+ public:
+  /**
+   * Build a prefetcher of the given kind (see above).
+   *
+   * @param depth the most pages to load ahead of one access
+   * @return the new prefetcher; nullptr if kind is not a known name
+   */
+  static std::unique_ptr<Prefetcher> make(const std::string& kind,
+                                          unsigned depth = 16);
+
+  /**
+   * @return the names of every kind, in the order listed above
+   */
+  static const std::vector<std::string>& kinds();
+
+  virtual ~Prefetcher() = default;
+
+  /**
+   * @return the kind, as given to make()
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * Process faulted on page, or (hit) used page for the first time since it
+   * was prefetched. Add the pages to load ahead to pages, most urgent first.
+   */
+  virtual void predict(ProcessId process, PageNumber page, bool hit,
+                       std::vector<PageNumber>& pages) = 0;
+
+  /**
+   * Process has exited: forget what was learned about it.
+   */
+  virtual void forget(ProcessId process) = 0;
+
+  /**
+   * Save what was learned about each process to a snapshot.
+   */
+  virtual void save(SnapshotWriter& out) const = 0;
+
+  /**
+   * Replace what was learned with what was saved to a snapshot by a
+   * prefetcher of the same kind.
+   *
+   * @throw std::runtime_error if the snapshot is bad
+   */
+  virtual void restore(SnapshotReader& in) = 0;
+
+  unsigned depth() const { return _depth; }
+
+ protected:
+  explicit Prefetcher(unsigned depth) : _depth(depth) {}
+
+  unsigned _depth;
+};
+
+#endif /* PREFETCHER_H */
@@ -0,0 +1,127 @@
+#include "stackDistance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+// sampling compares the low 24 bits of a page's hash with the threshold
+static const uint32_t sampleModulus = 1 << 24;
+// smallest Fenwick tree; it grows to twice the live pages on compaction
+static const size_t minimumPositions = 1 << 16;
+
+StackDistance::StackDistance(const Geometry& geometry, double rate)
+    : _geometry(geometry), _rate(rate), _tree(minimumPositions + 1) {
+  if (!(rate > 0 && rate <= 1))
+    throw std::invalid_argument("Sampling rate must be in (0, 1]");
+  _threshold = std::min<double>(std::ceil(rate * sampleModulus), sampleModulus);
+}
+
+size_t StackDistance::KeyHash::operator()(const Key& key) const {
+  // splitmix64 finalizer: every input bit affects the low 24 bits
+  uint64_t x = key.second * 0x9E3779B97F4A7C15ull + key.first;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+void StackDistance::add(size_t position, int delta) {
+  for (size_t i = position + 1; i < _tree.size(); i += i & -i)
+    _tree[i] += delta;
+}
+
+unsigned long StackDistance::prefix(size_t end) const {
+  unsigned long sum = 0;
+  for (size_t i = end; i > 0; i -= i & -i) sum += _tree[i];
+  return sum;
+}
+
+void StackDistance::compact() {
+  std::vector<std::pair<size_t, const Key*>> live;
+  live.reserve(_last.size());
+  for (const auto& [key, position] : _last) live.push_back({position, &key});
+  std::sort(live.begin(), live.end());
+  for (size_t i = 0; i < live.size(); i++) _last[*live[i].second] = i;
+  _next = live.size();
+  // a tree of all 1s in [0, _next): node i covers (i - lowbit(i), i]
+  _tree.assign(std::max(2 * _next, minimumPositions) + 1, 0);
+  for (size_t i = 1; i < _tree.size(); i++) {
+    size_t low = i - (i & -i);
+    _tree[i] = low >= _next ? 0 : std::min(i, _next) - low;
+  }
+}
+
+void StackDistance::access(ProcessId process, PageNumber page) {
+  ++_accesses;
+  Key key{process, page};
+  if (_threshold < sampleModulus &&
+      (KeyHash()(key) & (sampleModulus - 1)) >= _threshold)
+    return;
+  ++_sampled;
+  if (_next + 1 >= _tree.size()) compact();
+  auto [last, first] = _last.try_emplace(key, _next);
+  if (first) {
+    ++_cold;
+  } else {
+    unsigned long distance = prefix(_next) - prefix(last->second + 1);
+    if (distance >= _histogram.size()) _histogram.resize(distance + 1);
+    ++_histogram[distance];
+    add(last->second, -1);
+    last->second = _next;
+  }
+  add(_next++, 1);
+}
+
+void StackDistance::run(TraceReader& input) {
+  ProcessId process = 0;
+  TraceCommand cmd;
+  while (input.next(cmd)) {
+    if (cmd.op == TraceOp::READ || cmd.op == TraceOp::WRITE)
+      access(process, getPage(cmd.address, _geometry));
+    else if (cmd.op == TraceOp::PROCESS)
+      process = cmd.address;
+    else if (cmd.op == TraceOp::QUIT)
+      break;
+  }
+}
+
+unsigned long StackDistance::pages() const {
+  return std::lround(_last.size() / _rate);
+}
+
+std::vector<unsigned long> StackDistance::faults(size_t maxFrames) const {
+  // faults with F frames: first accesses plus distances >= F, scaled by 1/rate
+  std::vector<unsigned long> beyond(_histogram.size() + 1, 0);
+  for (size_t d = _histogram.size(); d > 0; d--)
+    beyond[d - 1] = beyond[d] + _histogram[d - 1];
+  std::vector<unsigned long> result;
+  for (size_t frames = 1; frames <= maxFrames; frames++) {
+    size_t d = std::ceil(frames * _rate);
+    unsigned long misses = _cold + (d < beyond.size() ? beyond[d] : 0);
+    result.push_back(
+        _sampled ? std::lround(double(misses) / _sampled * _accesses) : 0);
+  }
+  return result;
+}
+
+std::ostream& printMissRatioCurve(std::ostream& out,
+                                  const StackDistance& analysis,
+                                  size_t maxFrames) {
+  out << std::dec << std::setfill(' ') << "MissRatio-------\n";
+  out << "  accesses   " << analysis.accesses() << "\n";
+  if (analysis.rate() < 1)
+    out << "  sampled    " << analysis.sampled() << " (rate "
+        << analysis.rate() << ")\n";
+  out << "  pages      " << analysis.pages() << " distinct\n";
+  out << "    frames     faults  fault%\n";
+  std::vector<unsigned long> faults = analysis.faults(maxFrames);
+  for (size_t f = 0; f < faults.size(); f++) {
+    double rate =
+        analysis.accesses() ? 100.0 * faults[f] / analysis.accesses() : 0.0;
+    out << "  " << std::setw(8) << f + 1 << std::setw(11) << faults[f]
+        << std::setw(8) << std::fixed << std::setprecision(2) << rate << "\n";
+    out.unsetf(std::ios::floatfield);
+  }
+  out << "----------------\n";
+  return out;
+}
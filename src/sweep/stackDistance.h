@@ -0,0 +1,131 @@
+/**
+ * StackDistance class computes the LRU miss-ratio curve of a trace in one
+ * pass.
+ *
+ * The stack (reuse) distance of an access is the number of distinct pages
+ * touched since the last access to the same page; with F frames LRU (TIME)
+ * faults exactly on the first access to each page and on the accesses whose
+ * distance is at least F. So one histogram of distances gives the faults at
+ * every memory size.
+ *
+ * Each page is keyed by (process, page) and remembers the position of its
+ * last access in a Fenwick tree holding a 1 at the last access of every
+ * page; the distance is the count of 1s after that position, O(log n). The
+ * tree is compacted (live positions renumbered in order) when it fills, so
+ * its size follows the number of distinct pages, not the trace length.
+ *
+ * With a sampling rate below 1 only the pages whose hash falls below
+ * rate * 2^24 are tracked (spatial sampling, as in SHARDS): sampled
+ * distances are scaled by 1/rate and the miss ratio of the sampled accesses
+ * estimates that of the whole trace.
+ */
+
+#ifndef STACKDISTANCE_H
+#define STACKDISTANCE_H
+
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "traceReader.h"
+#include "virtualMemoryTypes.h"
+
+class StackDistance {
+ public:
+  /**
+   * @param geometry splits trace addresses into page and offset
+   * @param rate fraction of the pages to sample, (0, 1]
+   * @throw std::invalid_argument if rate is out of range
+   */
+  explicit StackDistance(const Geometry& geometry, double rate = 1.0);
+
+  /**
+   * Record one access to page of process.
+   */
+  void access(ProcessId process, PageNumber page);
+
+  /**
+   * Record every READ and WRITE of the trace, following PROCESS switches,
+   * up to the end or QUIT; other commands are ignored.
+   *
+   * @throw what input.next() throws
+   */
+  void run(TraceReader& input);
+
+  /**
+   * @return the number of accesses recorded (sampled or not)
+   */
+  unsigned long accesses() const { return _accesses; }
+
+  /**
+   * @return the number of accesses sampled
+   */
+  unsigned long sampled() const { return _sampled; }
+
+  /**
+   * @return the (estimated) number of distinct pages
+   */
+  unsigned long pages() const;
+
+  /**
+   * @return the sampling rate
+   */
+  double rate() const { return _rate; }
+
+  /**
+   * Fault counts for TIME (LRU) with 1 to maxFrames frames.
+   *
+   * @return element F - 1 is the (estimated) faults with F frames
+   */
+  std::vector<unsigned long> faults(size_t maxFrames) const;
+
+ private:
+  using Key = std::pair<ProcessId, PageNumber>;
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  // Fenwick tree over access positions
+  void add(size_t position, int delta);
+  unsigned long prefix(size_t end) const;  // 1s in [0, end)
+  void compact();
+
+  Geometry _geometry;
+  double _rate;
+  uint32_t _threshold;  // sample a page iff its hash's low 24 bits are below
+  unsigned long _accesses{0};
+  unsigned long _sampled{0};
+  unsigned long _cold{0};                // first accesses (sampled)
+  std::vector<unsigned long> _histogram;  // sampled accesses by distance
+  std::unordered_map<Key, size_t, KeyHash> _last;  // position of last access
+  std::vector<uint32_t> _tree;
+  size_t _next{0};  // position of the next access
+};
+
+/**
+ * Print the miss-ratio curve for 1 to maxFrames frames.
+ *
+ * Format:
+ * MissRatio-------
+ *   accesses   N
+ *   sampled    S (rate R)
+ *   pages      D distinct
+ *     frames     faults  fault%
+ *          F          P    R.RR
+ * ----------------
+ *
+ * the sampled line only if the rate is below 1; one line per frame count.
+ *
+ * @param out target output stream to print on
+ * @param analysis the distances recorded
+ * @param maxFrames the largest frame count to report
+ * @return out for continued processing of the output stream
+ */
+std::ostream& printMissRatioCurve(std::ostream& out,
+                                  const StackDistance& analysis,
+                                  size_t maxFrames);
+
+#endif /* STACKDISTANCE_H */
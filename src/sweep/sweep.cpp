@@ -0,0 +1,177 @@
+#include "sweep.h"
+
+#include <algorithm>
+#include <barrier>
+#include <exception>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+// events parsed per chunk; each chunk is handed to every worker at once
+static const size_t chunkSize = 1 << 16;
+
+Sweep::Machine::Machine(const SweepConfiguration& configuration,
+                        const SweepSettings& settings)
+    : ram(configuration.frames) {
+  processes = ProcessTable::make(settings.layout, settings.geometry,
+                                 settings.pages);
+  if (!processes)
+    throw std::invalid_argument("Unknown page table layout \"" +
+                                settings.layout + "\"");
+  mmu = std::make_unique<MMU>(ram, *processes, settings.tlb, settings.local,
+                              settings.io);
+  if (settings.hugeShift != 0 && !mmu->hugePages(settings.hugeShift))
+    throw std::invalid_argument("No page table level for the huge page size");
+  if (!settings.prefetcher.empty()) {
+    std::unique_ptr<Prefetcher> prefetcher =
+        Prefetcher::make(settings.prefetcher, settings.prefetchDepth);
+    if (!prefetcher)
+      throw std::invalid_argument("Unknown prefetcher \"" +
+                                  settings.prefetcher + "\"");
+    mmu->prefetcher(std::move(prefetcher));
+  }
+  std::unique_ptr<ReplacementPolicy> policy =
+      makePolicy(configuration.policy, ram);
+  if (!policy)
+    throw std::invalid_argument("Unknown policy \"" + configuration.policy +
+                                "\"");
+  mmu->policy(std::move(policy));
+}
+
+void Sweep::Machine::run(const std::vector<Event>& events) {
+  if (error) return;
+  try {
+    for (const Event& e : events) {
+      switch (e.op) {
+        case TraceOp::READ:
+        case TraceOp::WRITE:
+          if (clock == std::numeric_limits<EventTime>::max())
+            throw std::overflow_error(
+                "more accesses than the event clock counts");
+          mmu->access(e.page, ++clock, e.op == TraceOp::WRITE);
+          break;
+        case TraceOp::PROCESS:
+          mmu->switchTo(e.page);
+          break;
+        case TraceOp::FREE:
+          mmu->free(e.page);
+          break;
+        case TraceOp::FORK:
+          mmu->fork(e.page);
+          break;
+        case TraceOp::CLEAR:
+          mmu->clearReferenced();
+          break;
+        default:
+          break;
+      }
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+}
+
+Sweep::Sweep(const std::vector<SweepConfiguration>& configurations,
+             const SweepSettings& settings)
+    : _configurations(configurations), _geometry(settings.geometry) {
+  for (const SweepConfiguration& c : configurations)
+    _machines.push_back(std::make_unique<Machine>(c, settings));
+  _threads = settings.threads ? settings.threads
+                              : std::thread::hardware_concurrency();
+  _threads = std::clamp<unsigned>(_threads, 1, _machines.size());
+}
+
+bool Sweep::fill(TraceReader& input, std::vector<Event>& chunk) {
+  chunk.clear();
+  TraceCommand cmd;
+  while (!_quit && chunk.size() < chunkSize && input.next(cmd)) {
+    switch (cmd.op) {
+      case TraceOp::READ:
+      case TraceOp::WRITE:
+        chunk.push_back(Event{cmd.op, getPage(cmd.address, _geometry)});
+        break;
+      case TraceOp::PROCESS:
+      case TraceOp::FREE:
+      case TraceOp::FORK:
+        chunk.push_back(Event{cmd.op, cmd.address});
+        break;
+      case TraceOp::CLEAR:
+        chunk.push_back(Event{cmd.op, 0});
+        break;
+      case TraceOp::QUIT:
+        _quit = true;
+        break;
+      default:
+        break;
+    }
+  }
+  return !chunk.empty();
+}
+
+void Sweep::run(TraceReader& input) {
+  // the workers run chunk[phase % 2] while the reader fills the other; an
+  // empty chunk ends the run
+  std::vector<Event> chunk[2];
+  for (auto& c : chunk) c.reserve(chunkSize);
+  std::barrier<> phaseDone(_threads + 1);
+  std::exception_ptr error;
+
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < _threads; w++)
+    workers.emplace_back([this, w, &chunk, &phaseDone] {
+      for (unsigned phase = 0;; phase++) {
+        phaseDone.arrive_and_wait();
+        const std::vector<Event>& events = chunk[phase % 2];
+        if (events.empty()) return;
+        for (size_t m = w; m < _machines.size(); m += _threads)
+          _machines[m]->run(events);
+      }
+    });
+
+  auto fillOrStop = [&](std::vector<Event>& next) {
+    try {
+      fill(input, next);
+    } catch (...) {
+      error = std::current_exception();
+      next.clear();
+    }
+  };
+  fillOrStop(chunk[0]);
+  for (unsigned phase = 0;; phase++) {
+    phaseDone.arrive_and_wait();
+    if (chunk[phase % 2].empty()) break;
+    fillOrStop(chunk[(phase + 1) % 2]);
+  }
+  for (auto& worker : workers) worker.join();
+  if (error) std::rethrow_exception(error);
+  for (const auto& machine : _machines)
+    if (machine->error) std::rethrow_exception(machine->error);
+}
+
+std::vector<Statistics> Sweep::results() const {
+  std::vector<Statistics> statistics;
+  for (const auto& machine : _machines)
+    statistics.push_back(machine->mmu->statistics());
+  return statistics;
+}
+
+std::ostream& operator<<(std::ostream& out, const Sweep& sweep) {
+  std::vector<Statistics> results = sweep.results();
+  out << "Sweep-----------\n";
+  out << "    frames  policy     accesses     faults  fault%  evictions"
+         " write-backs  resident\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const SweepConfiguration& c = sweep.configurations()[i];
+    const Statistics& s = results[i];
+    out << std::dec << std::setfill(' ') << "  " << std::setw(8) << c.frames
+        << "  " << std::left << std::setw(8) << c.policy << std::right
+        << std::setw(11) << s.accesses() << std::setw(11) << s.faults
+        << std::setw(8) << std::fixed << std::setprecision(2)
+        << s.faultRate() << std::setw(11) << s.evictions << std::setw(12)
+        << s.writebacks << std::setw(10) << s.averageResident() << "\n";
+    out.unsetf(std::ios::floatfield);
+  }
+  out << "----------------\n";
+  return out;
+}
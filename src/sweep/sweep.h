@@ -0,0 +1,154 @@
+/**
+ * Sweep class simulates many machine configurations over one pass of a
+ * trace.
+ *
+ * Each configuration (a frame count and a replacement policy) gets its own
+ * RAM, page tables and MMU. The trace is read and parsed once, by the calling
+ * thread, into chunks of page-level events; worker threads each own a fixed
+ * subset of the configurations and run every chunk through them. While the
+ * workers run one chunk the reader fills the next, and a barrier between
+ * chunks is the only synchronization: no state is shared between
+ * configurations, so the workers take no locks.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mmu.h"
+#include "processTable.h"
+#include "ram.h"
+#include "statistics.h"
+#include "tlb.h"
+#include "traceReader.h"
+#include "virtualMemoryTypes.h"
+
+/**
+ * One machine configuration of a sweep.
+ */
+struct SweepConfiguration {
+  size_t frames;
+  std::string policy;
+};
+
+/**
+ * What every machine of a sweep has in common.
+ */
+struct SweepSettings {
+  std::string layout{"flat"};
+  Geometry geometry;
+  size_t pages{16};  // for the flat layout
+  TLB::Config tlb;
+  bool local{false};
+  IOCost io;
+  unsigned hugeShift{0};  // huge pages of 2^hugeShift pages; 0 for none
+  unsigned threads{0};  // 0 means one per hardware thread
+  std::string prefetcher;  // a Prefetcher kind; empty for none
+  unsigned prefetchDepth{16};
+};
+
+class Sweep {
+ public:
+  /**
+   * Build a machine for each configuration.
+   *
+   * @throw std::invalid_argument if a policy, the layout or the prefetcher
+   * is unknown, or the layout has no level for the huge page size
+   */
+  Sweep(const std::vector<SweepConfiguration>& configurations,
+        const SweepSettings& settings);
+
+  /**
+   * Run the whole trace through every machine.
+   *
+   * READ, WRITE, PROCESS, FREE, FORK and CLEAR are simulated; commands that
+   * only print or that select a policy are ignored, and QUIT ends the trace.
+   *
+   * @param input the trace to read
+   * @throw what input.next() throws, or what the first failing machine threw
+   * (e.g. for an address past the end of its page table, or
+   * std::overflow_error for an access past the largest EventTime); a machine
+   * stops at its first error, the others run to the end of the trace
+   */
+  void run(TraceReader& input);
+
+  /**
+   * @return the statistics of each configuration, in order
+   */
+  std::vector<Statistics> results() const;
+
+  /**
+   * @return the configurations, in order
+   */
+  const std::vector<SweepConfiguration>& configurations() const {
+    return _configurations;
+  }
+
+  /**
+   * @return the number of worker threads run() uses
+   */
+  unsigned threads() const { return _threads; }
+
+ private:
+  // one page-level command of the trace
+  struct Event {
+    TraceOp op;
+    PageNumber page;  // the pid of a PROCESS, FREE or FORK
+  };
+
+  // a simulated machine: one configuration's complete state
+  struct Machine {
+    Machine(const SweepConfiguration& configuration,
+            const SweepSettings& settings);
+
+    /**
+     * Run a chunk of events through the machine; does nothing once an event
+     * has failed.
+     */
+    void run(const std::vector<Event>& events);
+
+    RAM ram;
+    std::unique_ptr<ProcessTable> processes;
+    std::unique_ptr<MMU> mmu;
+    EventTime clock{0};
+    std::exception_ptr error;  // why the machine stopped early, if it did
+  };
+
+  /**
+   * Read and parse the next chunk of events from input.
+   *
+   * @return false if the trace has ended
+   */
+  bool fill(TraceReader& input, std::vector<Event>& chunk);
+
+  std::vector<SweepConfiguration> _configurations;
+  std::vector<std::unique_ptr<Machine>> _machines;
+  Geometry _geometry;
+  unsigned _threads;
+  bool _quit{false};
+};
+
+/**
+ * Output operator for the results of a sweep
+ *
+ * Format:
+ * Sweep-----------
+ *    frames  policy     accesses     faults  fault%  evictions write-backs  resident
+ *         F  NAME              N          P    R.RR          V           W      A.AA
+ * ----------------
+ *
+ * one line per configuration; resident is the average number of frames in
+ * use.
+ *
+ * @param out target output stream to print on
+ * @param sweep the sweep to report on
+ * @return out for continued processing of the output stream
+ */
+std::ostream& operator<<(std::ostream& out, const Sweep& sweep);
+
+#endif /* SWEEP_H */
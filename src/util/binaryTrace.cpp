@@ -0,0 +1,64 @@
+#include "binaryTrace.h"
+
+#include <cstring>
+
+bool BinaryTraceHeader::decode(std::string_view bytes) {
+  if (bytes.size() < size || std::memcmp(bytes.data(), magic, 4) != 0)
+    return false;
+  version = (unsigned char)bytes[4];
+  addressWidth = (unsigned char)bytes[5];
+  offsetWidth = (unsigned char)bytes[6];
+  return version == currentVersion;
+}
+
+void BinaryTraceHeader::encode(std::string& out) const {
+  out.append(magic, 4);
+  out.push_back(char(version));
+  out.push_back(char(addressWidth));
+  out.push_back(char(offsetWidth));
+  out.push_back(0);
+}
+
+void BinaryTraceEncoder::access(bool write, VirtualAddress address) {
+  VirtualAddress delta = address - _previous;
+  _previous = address;
+  // zigzag: small differences either way give small payloads
+  unsigned long long payload = (delta << 1) ^ (~(delta >> 63) + 1);
+  varint(write ? BinaryRecord::WRITE : BinaryRecord::READ, payload);
+}
+
+void BinaryTraceEncoder::command(std::string_view text) {
+  varint(BinaryRecord::COMMAND, text.size());
+  _out.append(text);
+}
+
+void BinaryTraceEncoder::varint(BinaryRecord kind, unsigned long long payload) {
+  unsigned char first =
+      (static_cast<unsigned char>(kind) << 5) | (payload & 0x1F);
+  payload >>= 5;
+  if (payload != 0) first |= 0x80;
+  _out.push_back(char(first));
+  while (payload != 0) {
+    unsigned char next = payload & 0x7F;
+    payload >>= 7;
+    if (payload != 0) next |= 0x80;
+    _out.push_back(char(next));
+  }
+}
+
+size_t decodeBinaryRecord(std::string_view bytes, BinaryRecord& kind,
+                          unsigned long long& payload) {
+  if (bytes.empty()) return 0;
+  unsigned char byte = bytes[0];
+  kind = static_cast<BinaryRecord>((byte >> 5) & 3);
+  payload = byte & 0x1F;
+  unsigned shift = 5;
+  size_t used = 1;
+  while (byte & 0x80) {
+    if (used == bytes.size() || used == 10) return 0;
+    byte = bytes[used++];
+    payload |= (unsigned long long)(byte & 0x7F) << shift;
+    shift += 7;
+  }
+  return used;
+}
@@ -0,0 +1,118 @@
+/**
+ * The binary trace format: a compact encoding of a text trace.
+ *
+ * A binary trace starts with an 8 byte header:
+ *
+ *   0..3  magic "\x89VMT" (never the start of a text trace)
+ *   4     format version (1)
+ *   5     virtual address width in bits
+ *   6     page offset width in bits (12 for 4K pages)
+ *   7     reserved (0)
+ *
+ * followed by one record per command. A record starts with a varint whose
+ * first byte holds a continuation bit, a 2-bit kind and the low 5 bits of
+ * the payload; every following byte holds a continuation bit and 7 more
+ * payload bits (so a 64-bit payload takes at most 10 bytes):
+ *
+ *   READ/WRITE  payload is the zigzag encoded difference from the previous
+ *               address (the first is relative to 0)
+ *   COMMAND     payload is the length of the command text (e.g. "PAGES",
+ *               "CLOCK"), which follows the varint
+ *
+ * A sequential READ takes one byte instead of the 15 of its text line.
+ */
+
+#ifndef BINARYTRACE_H
+#define BINARYTRACE_H
+
+#include <string>
+#include <string_view>
+
+#include "virtualMemoryTypes.h"
+
+/**
+ * The header of a binary trace.
+ */
+struct BinaryTraceHeader {
+  static constexpr char magic[4] = {'\x89', 'V', 'M', 'T'};
+  static constexpr size_t size = 8;
+  static constexpr unsigned currentVersion = 1;
+
+  unsigned version{currentVersion};
+  unsigned addressWidth{32};
+  unsigned offsetWidth{::offsetWidth};
+
+  /**
+   * Does the input start like a binary trace? One byte is enough to tell.
+   */
+  static bool detect(std::string_view start) {
+    return !start.empty() && start[0] == magic[0];
+  }
+
+  /**
+   * Decode the header at the start of bytes.
+   *
+   * @return true if bytes hold a whole header of a version this build reads
+   */
+  bool decode(std::string_view bytes);
+
+  /**
+   * Append the encoded header to out.
+   */
+  void encode(std::string& out) const;
+};
+
+/**
+ * The kind of a binary trace record (the 2 bits in its first byte).
+ */
+enum class BinaryRecord : unsigned char { READ, WRITE, COMMAND, RESERVED };
+
+/**
+ * Appends binary trace records to a string, keeping the previous address so
+ * addresses can be delta encoded.
+ */
+class BinaryTraceEncoder {
+ public:
+  /**
+   * Constructor: append to out, which must already hold the header.
+   */
+  BinaryTraceEncoder(std::string& out) : _out(out) {}
+
+  /**
+   * Append a READ (write false) or WRITE (write true) of address.
+   */
+  void access(bool write, VirtualAddress address);
+
+  /**
+   * Append any other command, as its text (comment and surrounding
+   * whitespace removed).
+   */
+  void command(std::string_view text);
+
+ private:
+  void varint(BinaryRecord kind, unsigned long long payload);
+
+  std::string& _out;
+  VirtualAddress _previous{0};
+};
+
+/**
+ * Decode the varint at the start of bytes.
+ *
+ * @param bytes at least the whole varint (up to 10 bytes)
+ * @param kind set to the record kind
+ * @param payload set to the payload
+ * @return the number of bytes used; 0 if bytes end inside the varint or it
+ *         is longer than 10 bytes
+ */
+size_t decodeBinaryRecord(std::string_view bytes, BinaryRecord& kind,
+                          unsigned long long& payload);
+
+/**
+ * Undo the zigzag encoding of an address difference.
+ */
+inline VirtualAddress unzigzag(unsigned long long payload) {
+  return (payload >> 1) ^ (~(payload & 1) + 1);
+}
+
+#endif /* BINARYTRACE_H */
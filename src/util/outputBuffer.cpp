@@ -0,0 +1,50 @@
+#include "outputBuffer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+OutputBuffer::OutputBuffer(int fd, size_t size) : _fd(fd), _buffer(size) {
+  setp(_buffer.data(), _buffer.data() + _buffer.size());
+}
+
+OutputBuffer::~OutputBuffer() { drain(); }
+
+bool OutputBuffer::drain() {
+  const char* next = pbase();
+  while (next < pptr()) {
+    ssize_t wrote = write(_fd, next, pptr() - next);
+    if (wrote < 0 && errno == EINTR) continue;
+    if (wrote <= 0) break;
+    next += wrote;
+  }
+  bool drained = (next == pptr());
+  setp(_buffer.data(), _buffer.data() + _buffer.size());
+  return drained;
+}
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type c) {
+  if (!drain()) return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize OutputBuffer::xsputn(const char* s, std::streamsize n) {
+  std::streamsize done = 0;
+  while (done < n) {
+    if (pptr() == epptr() && !drain()) break;
+    std::streamsize chunk =
+        std::min<std::streamsize>(n - done, epptr() - pptr());
+    std::memcpy(pptr(), s + done, chunk);
+    pbump(chunk);
+    done += chunk;
+  }
+  return done;
+}
+
+int OutputBuffer::sync() { return drain() ? 0 : -1; }
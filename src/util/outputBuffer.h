@@ -0,0 +1,99 @@
+/**
+ * OutputBuffer collects output in one large buffer and writes it to a file
+ * descriptor only when the buffer fills, on flush, or when it is destroyed.
+ *
+ * It is a std::streambuf, so an std::ostream on it takes the usual operator<<
+ * output (PAGES, FRAMES, ...) in order with the per-access records, which
+ * are formatted straight into the buffer by hex() and dec() without going
+ * through stream manipulators.
+ */
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+class OutputBuffer : public std::streambuf {
+ public:
+  /**
+   * Constructor: buffer output for the open file descriptor fd.
+   *
+   * @param fd where the output goes
+   * @param size bytes of output to collect between writes
+   */
+  OutputBuffer(int fd, size_t size = 1 << 20);
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  /**
+   * Append one character.
+   */
+  void put(char c) {
+    if (pptr() == epptr()) drain();
+    *pptr() = c;
+    pbump(1);
+  }
+
+  /**
+   * Append a string.
+   */
+  void append(std::string_view s) { xsputn(s.data(), s.size()); }
+
+  /**
+   * Append value in lower case hex, zero padded to at least width digits
+   * (like << hex << setw(width) << setfill('0')).
+   */
+  void hex(unsigned long long value, int width) {
+    static const char digits[] = "0123456789abcdef";
+    int n = 1;
+    while (n < 16 && (value >> (4 * n)) != 0) n++;
+    if (n < width) n = width;
+    char* end = reserve(n) + n;
+    for (char* p = end; p != end - n; value >>= 4) *--p = digits[value & 0xF];
+    pbump(n);
+  }
+
+  /**
+   * Append value in decimal.
+   */
+  void dec(unsigned long long value) {
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+      *--p = '0' + value % 10;
+      value /= 10;
+    } while (value != 0);
+    xsputn(p, digits + sizeof(digits) - p);
+  }
+
+ protected:
+  int_type overflow(int_type c) override;
+  std::streamsize xsputn(const char* s, std::streamsize n) override;
+  int sync() override;
+
+ private:
+  /**
+   * Make room for at least n characters, writing out the buffer if needed.
+   *
+   * @return where the characters go
+   */
+  char* reserve(size_t n) {
+    if (size_t(epptr() - pptr()) < n) drain();
+    return pptr();
+  }
+
+  /**
+   * Write out everything in the buffer.
+   *
+   * @return false if the write failed
+   */
+  bool drain();
+
+  int _fd;
+  std::vector<char> _buffer;
+};
+
+#endif /* OUTPUTBUFFER_H */
@@ -0,0 +1,103 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <system_error>
+
+// the header: magic, version and three reserved bytes
+static const char magic[4] = {'\x89', 'V', 'M', 'S'};
+static const unsigned char version = 2;
+static const size_t headerSize = 8;
+
+SnapshotWriter::SnapshotWriter(const std::string& path) : _path(path) {
+  _data.append(magic, sizeof(magic));
+  _data.push_back(char(version));
+  _data.append(headerSize - sizeof(magic) - 1, '\0');
+}
+
+void SnapshotWriter::append(const void* data, size_t n) {
+  _data.append(static_cast<const char*>(data), n);
+  _data.append((8 - n % 8) % 8, '\0');
+}
+
+void SnapshotWriter::commit() {
+  std::string temporary = _path + ".tmp";
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), temporary);
+  for (size_t done = 0; done < _data.size();) {
+    ssize_t wrote = write(fd, _data.data() + done, _data.size() - done);
+    if (wrote < 0 && errno == EINTR) continue;
+    if (wrote < 0) {
+      int error = errno;
+      close(fd);
+      unlink(temporary.c_str());
+      throw std::system_error(error, std::generic_category(), temporary);
+    }
+    done += wrote;
+  }
+  if (fsync(fd) != 0 || close(fd) != 0 ||
+      std::rename(temporary.c_str(), _path.c_str()) != 0) {
+    int error = errno;
+    unlink(temporary.c_str());
+    throw std::system_error(error, std::generic_category(), _path);
+  }
+}
+
+SnapshotReader::SnapshotReader(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::system_error(errno, std::generic_category(), path);
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+  _size = info.st_size;
+  if (_size >= headerSize) {
+    void* mapped = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      int error = errno;
+      close(fd);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    _mapped = static_cast<const char*>(mapped);
+  }
+  close(fd);
+  const char* problem = nullptr;
+  if (_mapped == nullptr || std::memcmp(_mapped, magic, sizeof(magic)) != 0)
+    problem = " is not a snapshot";
+  else if ((unsigned char)_mapped[sizeof(magic)] != version)
+    problem = ": unsupported snapshot version";
+  if (problem != nullptr) {
+    if (_mapped != nullptr) munmap(const_cast<char*>(_mapped), _size);
+    throw std::runtime_error(path + problem);
+  }
+  _cursor = headerSize;
+}
+
+SnapshotReader::~SnapshotReader() {
+  if (_mapped != nullptr) munmap(const_cast<char*>(_mapped), _size);
+}
+
+const char* SnapshotReader::take(size_t n) {
+  size_t padded = n + (8 - n % 8) % 8;
+  if (padded > _size - _cursor) truncated();
+  const char* start = _mapped + _cursor;
+  _cursor += padded;
+  return start;
+}
+
+void SnapshotReader::truncated() {
+  throw std::runtime_error("truncated snapshot");
+}
+
+void SnapshotReader::expect(uint64_t value, const std::string& what) {
+  if (get() != value)
+    throw std::runtime_error("snapshot was taken with a different " + what);
+}
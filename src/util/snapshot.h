@@ -0,0 +1,172 @@
+/**
+ * SnapshotWriter and SnapshotReader store the whole state of a simulation
+ * in a binary snapshot file (the CHECKPOINT and RESTORE commands), so a long
+ * run can be resumed where it left off.
+ *
+ * A snapshot starts with an 8 byte header:
+ *
+ *   0..3  magic "\x89VMS" (never the start of a text trace)
+ *   4     format version (2)
+ *   5..7  reserved (0)
+ *
+ * followed by what each part of the simulator saves, in the order it saves
+ * it: 64-bit values, and arrays of plain values (PTE, Frame, ...) as their
+ * 64-bit count followed by their bytes, padded to a multiple of 8 bytes.
+ * Values are in the byte order of the machine that wrote them: a snapshot
+ * resumes a run of the same build, it is not an exchange format.
+ *
+ * The reader maps the file and hands out each array as a span of the
+ * mapping, already aligned, so restoring a page table of 2^20 entries is one
+ * 4M copy, not a parse. The writer writes the snapshot to a temporary file
+ * beside the target and renames it into place, so a crash while writing
+ * leaves the previous snapshot whole.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+class SnapshotWriter {
+ public:
+  /**
+   * Constructor: start a snapshot to be written to path by commit().
+   */
+  explicit SnapshotWriter(const std::string& path);
+
+  /**
+   * Append a value.
+   */
+  void put(uint64_t value) { append(&value, sizeof(value)); }
+
+  /**
+   * Append an array of plain values.
+   */
+  template <typename T>
+  void putArray(std::span<const T> values) {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    put(values.size());
+    append(values.data(), values.size_bytes());
+  }
+
+  template <typename T>
+  void putArray(const std::vector<T>& values) {
+    putArray(std::span<const T>(values));
+  }
+
+  /**
+   * Append one plain value (e.g. a struct of counters) as an array of one.
+   */
+  template <typename T>
+  void putObject(const T& value) {
+    putArray(std::span<const T>(&value, 1));
+  }
+
+  void putString(std::string_view s) {
+    putArray(std::span<const char>(s.data(), s.size()));
+  }
+
+  /**
+   * Write the snapshot: to a temporary file, flushed to disk, then renamed
+   * to the path.
+   *
+   * @throw std::system_error if the file cannot be written
+   */
+  void commit();
+
+ private:
+  /**
+   * Append n bytes, then zeros up to a multiple of 8.
+   */
+  void append(const void* data, size_t n);
+
+  std::string _path;
+  std::string _data;
+};
+
+class SnapshotReader {
+ public:
+  /**
+   * Constructor: map the snapshot at path and check its header.
+   *
+   * @throw std::system_error if the file cannot be opened or mapped
+   * @throw std::runtime_error if it is not a snapshot of this version
+   */
+  explicit SnapshotReader(const std::string& path);
+  ~SnapshotReader();
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+  /**
+   * Get the next value.
+   *
+   * @throw std::runtime_error if the snapshot ends first
+   */
+  uint64_t get() {
+    uint64_t value;
+    std::memcpy(&value, take(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  /**
+   * Get the next array. The span points into the mapped file and stays
+   * valid as long as the reader.
+   *
+   * @throw std::runtime_error if the snapshot ends first
+   */
+  template <typename T>
+  std::span<const T> getArray() {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    uint64_t n = get();
+    if (n > (_size - _cursor) / sizeof(T)) truncated();
+    const T* values = reinterpret_cast<const T*>(take(n * sizeof(T)));
+    return std::span<const T>(values, n);
+  }
+
+  /**
+   * Get the next plain value saved by SnapshotWriter::putObject().
+   */
+  template <typename T>
+  T getObject() {
+    std::span<const T> value = getArray<T>();
+    if (value.size() != 1) throw std::runtime_error("bad snapshot");
+    return value[0];
+  }
+
+  std::string getString() {
+    std::span<const char> s = getArray<char>();
+    return std::string(s.begin(), s.end());
+  }
+
+  /**
+   * Get the next value, a setting of the run that saved it, and check it is
+   * the same in this run.
+   *
+   * @param what names the setting in the error
+   * @throw std::runtime_error if it differs
+   */
+  void expect(uint64_t value, const std::string& what);
+
+ private:
+  /**
+   * Consume n bytes, and the padding after them.
+   *
+   * @return where they start
+   */
+  const char* take(size_t n);
+
+  [[noreturn]] static void truncated();
+
+  const char* _mapped{nullptr};
+  size_t _size{0};
+  size_t _cursor{0};
+};
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,69 @@
+/**
+ * SpscRing is a bounded, lock-free queue between exactly one producer thread
+ * and one consumer thread.
+ *
+ * The producer only writes the tail index and the consumer only writes the
+ * head, so neither takes a lock: a push or pop is a few loads and one
+ * release store. A thread that finds the ring full (or empty) waits on the
+ * other's index with std::atomic::wait, which spins briefly before it
+ * sleeps, so a stalled stage costs no CPU. The ring is meant to carry
+ * pointers to large batches, which keeps that synchronization rare.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+ public:
+  /**
+   * Constructor: a ring of at least capacity slots (rounded up to a power
+   * of two).
+   */
+  explicit SpscRing(size_t capacity)
+      : _slots(std::bit_ceil(capacity < 1 ? 1 : capacity)),
+        _mask(_slots.size() - 1) {}
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  /**
+   * Append value; waits while the ring is full. Producer thread only.
+   */
+  void push(T value) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    for (uint32_t head; tail - (head = _head.load(std::memory_order_acquire)) >
+                        _mask;)
+      _head.wait(head, std::memory_order_acquire);
+    _slots[tail & _mask] = std::move(value);
+    _tail.store(tail + 1, std::memory_order_release);
+    _tail.notify_one();
+  }
+
+  /**
+   * Remove the oldest value; waits while the ring is empty. Consumer thread
+   * only.
+   */
+  T pop() {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    for (uint32_t tail; (tail = _tail.load(std::memory_order_acquire)) == head;)
+      _tail.wait(tail, std::memory_order_acquire);
+    T value = std::move(_slots[head & _mask]);
+    _head.store(head + 1, std::memory_order_release);
+    _head.notify_one();
+    return value;
+  }
+
+ private:
+  std::vector<T> _slots;
+  const uint32_t _mask;
+  // on separate cache lines, so the two threads do not share one
+  alignas(64) std::atomic<uint32_t> _head{0};  // next slot to pop
+  alignas(64) std::atomic<uint32_t> _tail{0};  // next slot to push
+};
+
+#endif /* SPSCRING_H */
@@ -2,6 +2,8 @@
 
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 using namespace std;
@@ -20,6 +22,54 @@ string trim_right(const string& orig) {
   return orig.substr(0, nonWhiteSpace + 1);
 }
 
+string_view trim(string_view orig) {
+  size_t first = orig.find_first_not_of(" \t\n\r");
+  if (first == string_view::npos) return string_view();
+  size_t last = orig.find_last_not_of(" \t\n\r");
+  return orig.substr(first, last - first + 1);
+}
+
+// value of each character as a hex digit; 0xFF if it is not one
+static const struct HexDigits {
+  unsigned char value[256];
+  HexDigits() {
+    for (int c = 0; c < 256; c++) value[c] = 0xFF;
+    for (int d = 0; d < 10; d++) value['0' + d] = d;
+    for (int d = 0; d < 6; d++) value['a' + d] = value['A' + d] = 10 + d;
+  }
+} hexDigits;
+
+unsigned long long parse_hex(string_view str) {
+  size_t i = 0;
+  bool negative = false;
+  if (i < str.size() && (str[i] == '+' || str[i] == '-'))
+    negative = (str[i++] == '-');
+  // "0x" is only a prefix if a hex digit follows it
+  if (i + 2 < str.size() && str[i] == '0' &&
+      (str[i + 1] == 'x' || str[i + 1] == 'X') &&
+      hexDigits.value[(unsigned char)str[i + 2]] != 0xFF)
+    i += 2;
+
+  size_t first = i;
+  unsigned long long value = 0;
+  for (unsigned char digit;
+       i < str.size() &&
+       (digit = hexDigits.value[(unsigned char)str[i]]) != 0xFF;
+       i++) {
+    if (value >> 60) throw out_of_range("stoull");
+    value = (value << 4) | digit;
+  }
+  if (i == first) throw invalid_argument("stoull");
+  return negative ? -value : value;
+}
+
+vector<string> split(const string& list, char delimiter) {
+  vector<string> fields;
+  stringstream in(list);
+  for (string field; getline(in, field, delimiter);) fields.push_back(field);
+  return fields;
+}
+
 string string_globally_replace(const string& orig, const string& to_be_replaced,
                                const string& replacement) {
   string result = orig;
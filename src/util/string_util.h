@@ -7,6 +7,8 @@
 #define STRING_UTIL_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 // A small collection of free-functions for manipulating std::string
 // objects.
@@ -32,6 +34,39 @@ std::string trim_left(const std::string& orig);
  */
 std::string trim_right(const std::string& orig);
 
+/**
+ * Return a view of the original with whitespace trimmed from both sides.
+ * Copies nothing.
+ *
+ * @param orig view to trim
+ * @return orig without leading or trailing whitespace (" \t\n\r"); result
+ *         will be empty if there are no non-whitespace characters.
+ * @note NOT locale aware
+ */
+std::string_view trim(std::string_view orig);
+
+/**
+ * Parse a hexadecimal number the way std::stoull(str, 0, 16) does: an
+ * optional sign, an optional "0x"/"0X" prefix, then hex digits up to the
+ * first non-hex character. Uses a lookup table rather than strtoull.
+ *
+ * @param str text to parse (not NUL terminated)
+ * @return the parsed value
+ * @throw std::invalid_argument if there are no digits
+ * @throw std::out_of_range if the value does not fit in 64 bits
+ */
+unsigned long long parse_hex(std::string_view str);
+
+/**
+ * Split a delimited list (e.g. a comma separated option argument) into its
+ * fields. An empty list has no fields; empty fields are kept otherwise.
+ *
+ * @param list the text to split
+ * @param delimiter the character between fields
+ * @return the fields, in order
+ */
+std::vector<std::string> split(const std::string& list, char delimiter = ',');
+
 /**
  * Globally replace instances of to_be_replaced with the replacement string.
  * No recursive replacement (the inserted text is not scanned). Returns a
@@ -0,0 +1,51 @@
+#include "temporaryFile.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <vector>
+
+int temporaryFile() {
+  const char* directory = std::getenv("TMPDIR");
+  std::string name =
+      std::string(directory ? directory : "/tmp") + "/vmSimulatorXXXXXX";
+  int fd = mkstemp(name.data());
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), name);
+  unlink(name.c_str());
+  return fd;
+}
+
+int rewindableInput(int fd) {
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) return fd;
+  int copy = temporaryFile();
+  std::vector<char> block(1 << 20);
+  for (;;) {
+    ssize_t got = read(fd, block.data(), block.size());
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0) break;
+    if (got == 0) {
+      lseek(copy, 0, SEEK_SET);
+      return copy;
+    }
+    for (ssize_t done = 0; done < got;) {
+      ssize_t wrote = write(copy, block.data() + done, got - done);
+      if (wrote < 0 && errno == EINTR) continue;
+      if (wrote < 0) {
+        int error = errno;
+        close(copy);
+        throw std::system_error(error, std::generic_category(),
+                                "copying the trace");
+      }
+      done += wrote;
+    }
+  }
+  int error = errno;
+  close(copy);
+  throw std::system_error(error, std::generic_category(), "reading the trace");
+}
@@ -0,0 +1,28 @@
+/**
+ * Scratch files for passes over a trace that do not fit in memory: anonymous
+ * (already unlinked) files in $TMPDIR, or /tmp, that disappear when closed.
+ */
+
+#ifndef TEMPORARYFILE_H
+#define TEMPORARYFILE_H
+
+/**
+ * Create an anonymous temporary file open for reading and writing.
+ *
+ * @return the file descriptor; the caller closes it
+ * @throw std::system_error if the file cannot be created
+ */
+int temporaryFile();
+
+/**
+ * Make input that can be read more than once: fd itself if it is a regular
+ * file, else (a pipe or terminal) a temporary file holding everything that
+ * is left to read on fd.
+ *
+ * @return a file descriptor positioned at the start of the input; fd or one
+ * the caller closes
+ * @throw std::system_error if reading or copying fails
+ */
+int rewindableInput(int fd);
+
+#endif /* TEMPORARYFILE_H */
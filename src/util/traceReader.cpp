@@ -0,0 +1,227 @@
+#include "traceReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "string_util.h"
+
+// size of each block read from a pipe or terminal
+static const size_t blockSize = 1 << 20;
+
+LineReader::LineReader(int fd) : _fd(fd) {
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped != MAP_FAILED) {
+      madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+      _mapped = static_cast<const char*>(mapped);
+      _mappedSize = info.st_size;
+      _cursor = _mapped;
+      _end = _mapped + _mappedSize;
+      _eof = true;
+      return;
+    }
+  }
+  _buffer.resize(blockSize);
+  _cursor = _end = _buffer.data();
+}
+
+LineReader::~LineReader() {
+  if (_mapped != nullptr) munmap(const_cast<char*>(_mapped), _mappedSize);
+}
+
+bool LineReader::fill() {
+  if (_eof) return false;
+  // slide the unread partial line to the front, growing if it fills the
+  // buffer
+  size_t unread = _end - _cursor;
+  _consumed += _cursor - _buffer.data();
+  std::memmove(_buffer.data(), _cursor, unread);
+  if (unread == _buffer.size()) _buffer.resize(2 * _buffer.size());
+  _cursor = _buffer.data();
+  _end = _cursor + unread;
+
+  ssize_t got;
+  do {
+    got = read(_fd, _buffer.data() + unread, _buffer.size() - unread);
+  } while (got < 0 && errno == EINTR);
+  if (got <= 0) {
+    _eof = true;
+    return false;
+  }
+  _end += got;
+  return true;
+}
+
+bool LineReader::next(std::string_view& line) {
+  const char* newline;
+  while ((newline = static_cast<const char*>(
+              std::memchr(_cursor, '\n', _end - _cursor))) == nullptr) {
+    if (!fill()) {
+      // last line without a '\n'
+      if (_cursor == _end) return false;
+      line = std::string_view(_cursor, _end - _cursor);
+      _cursor = _end;
+      return true;
+    }
+  }
+  line = std::string_view(_cursor, newline - _cursor);
+  _cursor = newline + 1;
+  return true;
+}
+
+void LineReader::seek(size_t offset) {
+  if (_mapped != nullptr) {
+    if (offset > _mappedSize)
+      throw std::runtime_error("position past the end of the trace");
+    _cursor = _mapped + offset;
+    return;
+  }
+  if (offset < position())
+    throw std::runtime_error("cannot go back in a trace that is not a file");
+  while (size_t(_end - _cursor) < offset - position()) {
+    _cursor = _end;
+    if (!fill())
+      throw std::runtime_error("position past the end of the trace");
+  }
+  _cursor += offset - position();
+}
+
+std::string_view LineReader::peek(size_t n) {
+  while (size_t(_end - _cursor) < n && fill()) {
+  }
+  return std::string_view(_cursor, std::min(n, size_t(_end - _cursor)));
+}
+
+/**
+ * Split the next whitespace separated word off the front of rest.
+ */
+static std::string_view nextWord(std::string_view& rest) {
+  size_t i = 0;
+  while (i < rest.size() && std::isspace((unsigned char)rest[i])) i++;
+  size_t start = i;
+  while (i < rest.size() && !std::isspace((unsigned char)rest[i])) i++;
+  std::string_view word = rest.substr(start, i - start);
+  rest.remove_prefix(i);
+  return word;
+}
+
+/**
+ * Parse a decimal process id.
+ */
+static ProcessId parsePid(std::string_view command, std::string_view word) {
+  ProcessId pid = 0;
+  auto [end, error] =
+      std::from_chars(word.data(), word.data() + word.size(), pid);
+  if (error == std::errc::result_out_of_range || pid == noSuchProcess)
+    throw std::out_of_range(std::string(command) +
+                            ": process id out of range");
+  if (error != std::errc() || end != word.data() + word.size())
+    throw std::invalid_argument(std::string(command) + ": bad process id");
+  return pid;
+}
+
+bool parseCommand(std::string_view line, TraceCommand& command) {
+  // strip eoln-comments and opening/closing whitespace
+  line = str_util::trim(line.substr(0, line.find('#')));
+  if (line.empty()) return false;
+
+  command.word = nextWord(line);
+  command.argument = nextWord(line);
+  command.address = 0;
+  const std::string_view& w = command.word;
+  if (w == "READ" || w == "WRITE") {
+    command.op = (w == "READ") ? TraceOp::READ : TraceOp::WRITE;
+    command.address = str_util::parse_hex(command.argument);
+  } else if (w == "PAGES") {
+    command.op = TraceOp::PAGES;
+  } else if (w == "FRAMES") {
+    command.op = TraceOp::FRAMES;
+  } else if (w == "CLEAR") {
+    command.op = TraceOp::CLEAR;
+  } else if (w == "TLB") {
+    command.op = TraceOp::TLB;
+  } else if (w == "PROCESS") {
+    command.op = TraceOp::PROCESS;
+    command.address = parsePid(w, command.argument);
+  } else if (w == "FREE") {
+    command.op = TraceOp::FREE;
+    command.address = parsePid(w, command.argument);
+  } else if (w == "FORK") {
+    command.op = TraceOp::FORK;
+    command.address = parsePid(w, command.argument);
+  } else if (w == "CHECKPOINT" || w == "RESTORE") {
+    command.op = (w == "CHECKPOINT") ? TraceOp::CHECKPOINT : TraceOp::RESTORE;
+    if (command.argument.empty())
+      throw std::invalid_argument(std::string(w) + ": no snapshot file");
+  } else if (w == "quit" || w == "Quit" || w == "QUIT" || w == "exit" ||
+             w == "Exit" || w == "EXIT") {
+    command.op = TraceOp::QUIT;
+  } else {
+    command.op = TraceOp::OTHER;
+  }
+  return true;
+}
+
+TraceReader::TraceReader(int fd) : _input(fd) {
+  if (isatty(fd) || !BinaryTraceHeader::detect(_input.peek(1))) return;
+  if (!_header.decode(_input.peek(BinaryTraceHeader::size)))
+    throw std::runtime_error("bad binary trace header");
+  _input.skip(BinaryTraceHeader::size);
+  _binary = true;
+}
+
+bool TraceReader::next(TraceCommand& command) {
+  if (_binary) return nextRecord(command);
+  std::string_view line;
+  if (!_input.next(line)) return false;
+  if (!parseCommand(line, command)) command.op = TraceOp::NONE;
+  return true;
+}
+
+void TraceReader::seek(const TracePosition& position) {
+  _input.seek(position.offset);
+  _previous = position.previous;
+}
+
+bool TraceReader::nextRecord(TraceCommand& command) {
+  // a varint is at most 10 bytes
+  std::string_view bytes = _input.peek(10);
+  if (bytes.empty()) return false;
+  BinaryRecord kind;
+  unsigned long long payload;
+  size_t used = decodeBinaryRecord(bytes, kind, payload);
+  if (used == 0) throw std::runtime_error("bad binary trace record");
+
+  switch (kind) {
+    case BinaryRecord::READ:
+    case BinaryRecord::WRITE:
+      _input.skip(used);
+      _previous += unzigzag(payload);
+      command.op =
+          (kind == BinaryRecord::READ) ? TraceOp::READ : TraceOp::WRITE;
+      command.word = (kind == BinaryRecord::READ) ? "READ" : "WRITE";
+      command.argument = std::string_view();
+      command.address = _previous;
+      return true;
+    case BinaryRecord::COMMAND:
+      bytes = _input.peek(used + payload);
+      if (bytes.size() < used + payload)
+        throw std::runtime_error("truncated binary trace record");
+      _input.skip(used + payload);
+      if (!parseCommand(bytes.substr(used), command))
+        command.op = TraceOp::NONE;
+      return true;
+    default:
+      throw std::runtime_error("bad binary trace record");
+  }
+}
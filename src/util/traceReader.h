@@ -0,0 +1,209 @@
+/**
+ * LineReader and parseCommand read trace commands without copying them.
+ *
+ * A LineReader maps a regular file into memory (or block-reads a pipe or
+ * terminal into one large buffer) and hands out each line as a string_view
+ * into that memory. parseCommand strips the comment and whitespace from a
+ * line and classifies the command in place, decoding READ/WRITE addresses
+ * with a table-driven hex parser. Nothing is allocated per line.
+ *
+ * TraceReader puts the two together, and also decodes binary traces (see
+ * binaryTrace.h) straight out of the LineReader's memory.
+ */
+
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "binaryTrace.h"
+#include "virtualMemoryTypes.h"
+
+class LineReader {
+ public:
+  /**
+   * Constructor: read lines from the open file descriptor fd.
+   */
+  LineReader(int fd);
+  ~LineReader();
+  LineReader(const LineReader&) = delete;
+  LineReader& operator=(const LineReader&) = delete;
+
+  /**
+   * Get the next line, without its '\n'. The view stays valid until the
+   * next call. A last line without a '\n' is still returned.
+   *
+   * @param line set to the line read
+   * @return false at end of input
+   */
+  bool next(std::string_view& line);
+
+  /**
+   * Look at the next n unread bytes without consuming them. The view stays
+   * valid until the next call.
+   *
+   * @return the next n bytes; fewer only at end of input
+   */
+  std::string_view peek(size_t n);
+
+  /**
+   * Consume n bytes; no more than the last peek() returned.
+   */
+  void skip(size_t n) { _cursor += n; }
+
+  /**
+   * @return the number of bytes consumed since the start of the input
+   */
+  size_t position() const {
+    return _mapped != nullptr ? _cursor - _mapped
+                              : _consumed + (_cursor - _buffer.data());
+  }
+
+  /**
+   * Go to offset bytes from the start of the input: anywhere in a mapped
+   * file, only forward (by reading up to it) in a pipe or terminal.
+   *
+   * @throw std::runtime_error if offset is past the end of the input, or
+   *        behind the position in input that is not mapped
+   */
+  void seek(size_t offset);
+
+ private:
+  /**
+   * Block-read more input after the unread part of the buffer.
+   *
+   * @return false if there was nothing more to read
+   */
+  bool fill();
+
+  int _fd;
+  const char* _mapped{nullptr};  // whole file, if it could be mapped
+  size_t _mappedSize{0};
+  std::vector<char> _buffer;     // otherwise read() into this
+  const char* _cursor{nullptr};  // next unread character
+  const char* _end{nullptr};     // end of valid input in memory
+  size_t _consumed{0};  // bytes read and dropped from the front of _buffer
+  bool _eof{false};
+};
+
+/**
+ * The commands the command loop dispatches on. OTHER covers everything else
+ * (policy names, unknown commands); its word is in TraceCommand::word.
+ */
+enum class TraceOp : unsigned char {
+  READ,
+  WRITE,
+  PAGES,
+  FRAMES,
+  CLEAR,
+  TLB,
+  PROCESS,
+  FREE,
+  FORK,
+  CHECKPOINT,
+  RESTORE,
+  QUIT,
+  OTHER,
+  NONE  // a blank or comment-only line
+};
+
+/**
+ * One parsed trace command. The views point into the line it came from.
+ */
+struct TraceCommand {
+  TraceOp op;
+  std::string_view word;      // the command word
+  std::string_view argument;  // the next word: the address of a READ/WRITE,
+                              // the file of a CHECKPOINT/RESTORE
+  VirtualAddress address;  // decoded for READ/WRITE; the pid of
+                           // PROCESS/FREE/FORK
+};
+
+/**
+ * Parse one line of a trace. '#' starts a comment; leading and trailing
+ * whitespace is ignored; words are separated by whitespace and any words
+ * after the argument are ignored.
+ *
+ * @param line the line to parse
+ * @param command filled in with the command
+ * @return false if the line is blank (after removing the comment)
+ * @throw std::invalid_argument, std::out_of_range on a bad address, as
+ *        std::stoull would, or on a bad PROCESS, FREE or FORK id
+ * @throw std::invalid_argument on a CHECKPOINT or RESTORE without a file
+ */
+bool parseCommand(std::string_view line, TraceCommand& command);
+
+/**
+ * Where a TraceReader is in its input: enough to carry on reading from
+ * there, in this run or (through a snapshot) another run of the same trace.
+ */
+struct TracePosition {
+  uint64_t offset{0};          // bytes consumed from the start of input
+  VirtualAddress previous{0};  // of a binary trace: the last address
+};
+
+/**
+ * Reads trace commands from a text or a binary trace. The format is chosen
+ * from the first byte of input; a terminal is always read as text.
+ */
+class TraceReader {
+ public:
+  /**
+   * Constructor: read the trace from the open file descriptor fd.
+   *
+   * @throw std::runtime_error if a binary trace has a bad header
+   */
+  TraceReader(int fd);
+
+  /**
+   * Is the input a binary trace?
+   */
+  bool binary() const { return _binary; }
+
+  /**
+   * The header of a binary trace; the default geometry for a text trace.
+   */
+  const BinaryTraceHeader& header() const { return _header; }
+
+  /**
+   * Get the next command: one line of a text trace (op NONE if it is blank)
+   * or one record of a binary trace.
+   *
+   * @param command filled in with the command; its views stay valid until
+   *        the next call
+   * @return false at end of input
+   * @throw std::invalid_argument, std::out_of_range on a bad text address
+   * @throw std::runtime_error on a truncated or malformed binary record
+   */
+  bool next(TraceCommand& command);
+
+  /**
+   * @return the position after the last command read
+   */
+  TracePosition position() const {
+    return TracePosition{_input.position(), _previous};
+  }
+
+  /**
+   * Go to a position a TraceReader on the same input was at; the next
+   * command is the one read after it there.
+   *
+   * @throw std::runtime_error as LineReader::seek does
+   */
+  void seek(const TracePosition& position);
+
+ private:
+  /**
+   * Decode the next binary record.
+   */
+  bool nextRecord(TraceCommand& command);
+
+  LineReader _input;
+  bool _binary{false};
+  BinaryTraceHeader _header;
+  VirtualAddress _previous{0};
+};
+
+#endif /* TRACEREADER_H */
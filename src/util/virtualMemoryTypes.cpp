@@ -1,7 +1,27 @@
 #include "virtualMemoryTypes.h"
 
-PageNumber getPage(VirtualAddress va) {
-  return ((va & pageMask) >> offsetWidth);
-}
+bool Geometry::parsePageSize(const std::string& size) {
+  unsigned long long bytes;
+  size_t end;
+  try {
+    bytes = std::stoull(size, &end, 0);
+  } catch (const std::exception&) {
+    return false;
+  }
+  std::string suffix = size.substr(end);
+  if (suffix == "K" || suffix == "k")
+    bytes <<= 10;
+  else if (suffix == "M" || suffix == "m")
+    bytes <<= 20;
+  else if (suffix == "G" || suffix == "g")
+    bytes <<= 30;
+  else if (!suffix.empty())
+    return false;
 
-Offset getOffset(VirtualAddress va) { return (va & offsetMask); }
\ No newline at end of file
+  for (unsigned width = 9; width <= 30; width++)
+    if (bytes == (1ULL << width)) {
+      offsetWidth = width;
+      return true;
+    }
+  return false;
+}
@@ -1,22 +1,27 @@
 #ifndef VIRTUALMEMORYTYPES_H
 #define VIRTUALMEMORYTYPES_H
 
+#include <string>
+
 /**
  * Type Declarations for clarity
  */
-using PageNumber = unsigned int;
+using PageNumber = unsigned long long;
 using FrameNumber = unsigned int;
 using EventTime = unsigned int;
 using Offset = unsigned int;
-using VirtualAddress = unsigned int;
+using VirtualAddress = unsigned long long;
 using PhysicalAddress = unsigned int;
+using ProcessId = unsigned int;
 
 /**
  * Null Values and Masking for bitwise operations
+ * The masks describe the default geometry: 32-bit addresses, 4 KiB pages.
  */
-const PageNumber noSuchPage = 0xFFFFF;
+const PageNumber noSuchPage = 0xFFFFFFFFFFFFFFFF;
 const FrameNumber noSuchFrame = 0xFFFFF;
-const unsigned int pageMask = 0xFFFFF000;
+const ProcessId noSuchProcess = 0xFFFFFFFF;
+const VirtualAddress pageMask = 0xFFFFF000;
 const unsigned int frameMask = 0xFFFFF000;
 const unsigned int offsetMask = 0x00000FFF;
 const unsigned int offsetWidth = 12;  // Represented in bits
@@ -26,10 +31,12 @@ const unsigned int offsetWidth = 12;  // Represented in bits
  * Mask out the pageTable bits and shift right(depending on how you are viewing
  * endianess) by 12 bits, equivalent to 4 hex digits (as seen in the mask above)
  *
- * @param  {VirtualAddress} va : represented as an unint
+ * @param  {VirtualAddress} va : represented as an unsigned long long
  * @return {PageNumber}        : return index into pageTable as uint
  */
-PageNumber getPage(VirtualAddress va);
+inline PageNumber getPage(VirtualAddress va) {
+  return ((va & pageMask) >> offsetWidth);
+}
 
 /**
  * Using bitwise operations, return offset.
@@ -38,6 +45,77 @@ PageNumber getPage(VirtualAddress va);
  * @param  {VirtualAddress} va : represented as an unint
  * @return {PageNumber}        : return offset as uint
  */
-Offset getOffset(VirtualAddress va);
+inline Offset getOffset(VirtualAddress va) { return (va & offsetMask); }
+
+/**
+ * Memory geometry chosen at run time: the page size (as the width of the
+ * offset) and the width of a virtual address, both in bits. Addresses are
+ * 64-bit so 48-bit (x86-64) address spaces can be traced.
+ */
+struct Geometry {
+  unsigned offsetWidth{::offsetWidth};
+  unsigned addressWidth{32};
+
+  VirtualAddress addressMask() const {
+    return (addressWidth >= 64) ? ~VirtualAddress(0)
+                                : (VirtualAddress(1) << addressWidth) - 1;
+  }
+  VirtualAddress offsetMask() const {
+    return (VirtualAddress(1) << offsetWidth) - 1;
+  }
+  VirtualAddress pageMask() const { return addressMask() & ~offsetMask(); }
+
+  /**
+   * @return number of bits in a page number
+   */
+  unsigned pageWidth() const { return addressWidth - offsetWidth; }
+
+  /**
+   * Set offsetWidth from a page size in bytes, with an optional K, M or G
+   * suffix: "4K", "16K", "64K", "2M", ...
+   *
+   * @return true if size is a power of two from 512 bytes to 1G
+   */
+  bool parsePageSize(const std::string& size);
+};
+
+/**
+ * Geometry fixed at compile time. Same interface as Geometry, but every mask
+ * and shift is a constant the compiler can fold into the hot loop.
+ */
+template <unsigned OffsetWidth, unsigned AddressWidth>
+struct FixedGeometry {
+  static constexpr unsigned offsetWidth = OffsetWidth;
+  static constexpr unsigned addressWidth = AddressWidth;
+
+  static constexpr VirtualAddress addressMask() {
+    return (AddressWidth >= 64) ? ~VirtualAddress(0)
+                                : (VirtualAddress(1) << AddressWidth) - 1;
+  }
+  static constexpr VirtualAddress offsetMask() {
+    return (VirtualAddress(1) << OffsetWidth) - 1;
+  }
+  static constexpr VirtualAddress pageMask() {
+    return addressMask() & ~offsetMask();
+  }
+};
+
+/**
+ * Return the page number of va under the given geometry (a Geometry or a
+ * FixedGeometry).
+ */
+template <typename G>
+inline PageNumber getPage(VirtualAddress va, const G& geometry) {
+  return (va & geometry.pageMask()) >> geometry.offsetWidth;
+}
+
+/**
+ * Return the offset of va under the given geometry (a Geometry or a
+ * FixedGeometry).
+ */
+template <typename G>
+inline Offset getOffset(VirtualAddress va, const G& geometry) {
+  return va & geometry.offsetMask();
+}
 
 #endif /* VIRTUALMEMORYTYPES_H */
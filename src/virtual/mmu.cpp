@@ -0,0 +1,301 @@
+#include "mmu.h"
+
+#include <stdexcept>
+
+#include "snapshot.h"
+
+MMU::MMU(RAM& ram, ProcessTable& processes, const TLB::Config& tlb,
+         bool local, const IOCost& io)
+    : _ram(ram),
+      _processes(processes),
+      _pageTable(&processes[0]),
+      _local(local),
+      _io(io),
+      _policy(makePolicy("TIME", ram)),
+      _tlb(tlb) {
+  _periods.push_back(PolicyPeriod{_policy->name()});
+}
+
+Translation MMU::access(PageNumber page, EventTime now, bool write) {
+  if (write)
+    _statistics.writes++;
+  else
+    _statistics.reads++;
+
+  // a write goes to tables of the process's own, and a page of its own
+  if (write && _pageTable->forked()) unshare(page);
+  bool copied = false;
+
+  Translation result{noSuchFrame, false};
+  bool prefetchHit = false;
+  PTE* pte = _tlb.lookup(page);
+  if (pte != nullptr && write && copyOnWrite(page, *pte)) {
+    copied = true;
+    pte = nullptr;
+  }
+  if (pte != nullptr) {
+    result.frame = pte->frame();
+    if (pte->large()) result.frame += page & (_ram.hugeRun() - 1);
+  } else {
+    result.frame = _pageTable->lookup(page);
+    if (result.frame != noSuchFrame && write && !copied &&
+        copyOnWrite(page, _pageTable->translation(page))) {
+      copied = true;
+      result.frame = noSuchFrame;
+    }
+    if (result.frame == noSuchFrame) {
+      // page is not loaded in a frame (page fault interrupt)
+      if (_pageTable->forked()) unshare(page);
+      release(now);
+      size_t run = 1;
+      if (_pageTable->hugeEligible(page)) {
+        result.frame =
+            _ram.loadHuge(_process, page, *_pageTable, *_policy, _local);
+        if (_ram.lastLoadHuge()) {
+          run = _ram.hugeRun();
+          _statistics.hugeLoads++;
+        } else {
+          _statistics.hugeFallbacks++;
+        }
+      } else {
+        result.frame =
+            _ram.load(_process, page, *_pageTable, *_policy, _local);
+      }
+      result.pageFault = true;
+      _statistics.faults++;
+      if (copied)
+        _statistics.cowFaults++;  // a copy in memory, nothing to page in
+      else
+        _statistics.ioCycles += run * _io.pageInCycles;
+      evicted();
+    } else if (_ram[result.frame].prefetched()) {
+      // the first use of a prefetched page: the fault it saved
+      _ram[result.frame].prefetched(false);
+      _statistics.prefetchHits++;
+      prefetchHit = true;
+    }
+    pte = &_pageTable->translation(page);
+    if (!pte->used()) {
+      pte->used(true);
+      _statistics.pages++;
+    }
+    _tlb.insert(page, pte,
+                pte->large() ? _pageTable->hugeLevels() : _pageTable->levels());
+  }
+
+  _statistics.residentTime += _ram.used();
+
+  // frame is frame of this address; a huge page is stamped at its head
+  FrameNumber head = pte->large() ? pte->frame() : result.frame;
+  _ram[head].timestamp(now);
+  if (head != result.frame) _ram[result.frame].timestamp(now);
+  pte->referenced(true);
+  if (write) pte->dirty(true);
+  // the policies see a shared page's references at its first mapping; it
+  // is charged to this process once the process that loaded it has exited
+  if (_ram[head].mappings() > 1) _ram.mapping(head)->referenced(true);
+  if (_ram[head].process() != _process &&
+      !_processes.contains(_ram[head].process()))
+    _ram.charge(head, _process);
+  _policy->touched(head, _ram);
+  // after the access, so the prefetches never replace the page accessed
+  if (_prefetcher && (result.pageFault || prefetchHit))
+    prefetch(page, now, prefetchHit);
+  return result;
+}
+
+void MMU::evicted() {
+  PageNumber page = _ram.lastEvicted();
+  if (page == noSuchPage) return;
+  bool huge = _ram.lastEvictedHuge();
+  _tlb.invalidate(page, _ram.lastEvictedProcess());
+  _statistics.evictions++;
+  if (_ram.lastEvictedDirty()) {
+    _statistics.writebacks++;
+    _statistics.ioCycles += (huge ? _ram.hugeRun() : 1) * _io.pageOutCycles;
+  }
+}
+
+void MMU::prefetch(PageNumber page, EventTime now, bool hit) {
+  _predicted.clear();
+  _prefetcher->predict(_process, page, hit, _predicted);
+  for (PageNumber p : _predicted) {
+    // regions that may still be mapped huge are left to their faults
+    if (p >= _pageTable->size() || _pageTable->lookup(p) != noSuchFrame ||
+        _pageTable->hugeEligible(p))
+      continue;
+    if (_pageTable->forked()) unshare(p);
+    if (_ram.prefetch(_process, p, *_pageTable, *_policy, _local, now) ==
+        noSuchFrame)
+      break;
+    _statistics.prefetches++;
+    _statistics.ioCycles += _io.pageInCycles;
+    evicted();
+  }
+}
+
+bool MMU::hugePages(unsigned shift) {
+  if (!_processes.hugePages(shift)) return false;
+  _ram.hugePages(size_t(1) << shift);
+  _tlb.hugePages(shift);
+  return true;
+}
+
+void MMU::release(EventTime now) {
+  _released.clear();
+  _policy->release(_ram, _process, now, _released);
+  for (FrameNumber f : _released) {
+    bool huge = _ram.mapping(f)->large();
+    _tlb.invalidate(_ram[f].page(), _ram[f].process());
+    _statistics.releases++;
+    if (_ram.release(f, *_policy)) {
+      _statistics.writebacks++;
+      _statistics.ioCycles += (huge ? _ram.hugeRun() : 1) * _io.pageOutCycles;
+    }
+  }
+}
+
+void MMU::clearReferenced() {
+  _processes.clearReferenced();
+  _policy->referencesCleared(_ram);
+  _tlb.referencesCleared();
+}
+
+void MMU::switchTo(ProcessId pid) {
+  if (pid == _process) return;
+  _pageTable = &_processes[pid];
+  _process = pid;
+  _tlb.switchTo(pid);
+}
+
+size_t MMU::free(ProcessId pid) {
+  if (_prefetcher) _prefetcher->forget(pid);
+  size_t frames = 0;
+  if (PageTable* table = _processes.find(pid))
+    frames = _ram.releaseProcess(*table, *_policy);
+  _tlb.forget(pid);
+  _processes.erase(pid);
+  if (pid == _process) _pageTable = &_processes[pid];
+  return frames;
+}
+
+void MMU::fork(ProcessId pid) {
+  if (pid == _process) return;
+  if (_processes.contains(pid)) free(pid);
+  _processes.fork(_process, pid);
+  _statistics.forks++;
+}
+
+MemoryUse MMU::memoryUse() const {
+  MemoryUse use;
+  use.tableBytes = _processes.bytes();
+  if (_statistics.forks == 0) return use;
+  use.mappedPages = _processes.mappedPages();
+  use.frames = _ram.used();
+  use.privateTableBytes = _processes.privateBytes();
+  return use;
+}
+
+void MMU::unshare(PageNumber page) {
+  _copies.clear();
+  size_t copied = _pageTable->unshare(page, _copies);
+  if (copied == 0) return;
+  for (PTE* pte : _copies) _ram.share(*pte);
+  _statistics.tablesCopied += copied;
+  _tlb.forget(_process);
+}
+
+bool MMU::copyOnWrite(PageNumber page, PTE& pte) {
+  FrameNumber head = pte.frame();
+  if (_ram[head].mappings() < 2) return false;
+  _ram.unmap(head, pte);
+  _tlb.invalidate(page, _process);
+  return true;
+}
+
+void MMU::policy(std::unique_ptr<ReplacementPolicy> newPolicy) {
+  closePeriod(_periods.back());
+  _policy = std::move(newPolicy);
+  _periods.push_back(PolicyPeriod{_policy->name(), _statistics});
+}
+
+std::vector<PolicyPeriod> MMU::policyPeriods() const {
+  std::vector<PolicyPeriod> periods = _periods;
+  closePeriod(periods.back());
+  return periods;
+}
+
+void MMU::closePeriod(PolicyPeriod& period) const {
+  period.end = _statistics;
+  period.counters = _policy->counters();
+}
+
+void MMU::save(SnapshotWriter& out) const {
+  _processes.save(out);
+  _ram.save(out, _processes);
+  out.put(_process);
+  out.put(_local);
+  out.put(_io.pageInCycles);
+  out.put(_io.pageOutCycles);
+  _tlb.save(out);
+  out.putObject(_statistics);
+  out.put(_periods.size());
+  for (const PolicyPeriod& period : _periods) {
+    out.putString(period.name);
+    out.putObject(period.start);
+    out.putObject(period.end);
+    out.put(period.counters.size());
+    for (const auto& [label, count] : period.counters) {
+      out.putString(label);
+      out.put(count);
+    }
+  }
+  _policy->save(out);
+  out.put(_prefetcher != nullptr);
+  if (_prefetcher) {
+    out.putString(_prefetcher->name());
+    out.put(_prefetcher->depth());
+    _prefetcher->save(out);
+  }
+}
+
+void MMU::restore(SnapshotReader& in) {
+  _processes.restore(in);
+  _ram.restore(in, _processes);
+  ProcessId process = in.get();
+  _pageTable = &_processes[process];
+  _process = process;
+  in.expect(_local, "replacement scope");
+  in.expect(_io.pageInCycles, "page-in cost");
+  in.expect(_io.pageOutCycles, "page-out cost");
+  _tlb.restore(in, _processes);
+  _statistics = in.getObject<Statistics>();
+  std::vector<PolicyPeriod> periods(in.get());
+  for (PolicyPeriod& period : periods) {
+    period.name = in.getString();
+    period.start = in.getObject<Statistics>();
+    period.end = in.getObject<Statistics>();
+    period.counters.resize(in.get());
+    for (auto& [label, count] : period.counters) {
+      label = in.getString();
+      count = in.get();
+    }
+  }
+  if (periods.empty()) throw std::runtime_error("bad snapshot");
+  std::unique_ptr<ReplacementPolicy> policy =
+      makePolicy(periods.back().name, _ram);
+  if (!policy)
+    throw std::runtime_error("snapshot policy " + periods.back().name +
+                             " cannot run");
+  policy->restore(in, _ram);
+  _policy = std::move(policy);
+  _periods = std::move(periods);
+  in.expect(_prefetcher != nullptr, "prefetcher");
+  if (_prefetcher) {
+    if (in.getString() != _prefetcher->name())
+      throw std::runtime_error("snapshot was taken with a different "
+                               "prefetcher");
+    in.expect(_prefetcher->depth(), "prefetch depth");
+    _prefetcher->restore(in);
+  }
+}
@@ -0,0 +1,247 @@
+/**
+ * MMU class implements the translation path of one access: the TLB, then the
+ * PageTable of the running process, then (on a page fault) loading the page
+ * into RAM under the active ReplacementPolicy, globally or locally.
+ *
+ * The MMU does not own the RAM or the processes' PageTables; it points at
+ * the running process's table, so a context switch is a pointer swap (and a
+ * TLB address space change). It owns the TLB and the
+ * replacement policy, and the Prefetcher if there is one. It also keeps the
+ * run's Statistics, and remembers the totals each time the policy changes so
+ * they can be reported per policy.
+ *
+ * A FORK gives the child process the parent's page tables, shared
+ * copy-on-write (see PageTable::fork()). A write under a shared table copies
+ * the tables on the path to the page first; a write to a page whose frame
+ * another process still maps is a copy-on-write fault: the page is unmapped
+ * from the writer and faults into a frame of its own, without the I/O of
+ * paging it in.
+ */
+
+#ifndef MMU_H
+#define MMU_H
+
+#include <memory>
+#include <vector>
+
+#include "pageTable.h"
+#include "prefetcher.h"
+#include "processTable.h"
+#include "ram.h"
+#include "replacementPolicy.h"
+#include "statistics.h"
+#include "tlb.h"
+#include "virtualMemoryTypes.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * Result of translating one access.
+ */
+struct Translation {
+  FrameNumber frame;
+  bool pageFault;
+};
+
+class MMU {
+ public:
+  /**
+   * Constructor: translate through the page tables of processes into ram,
+   * starting with process 0 and the TIME policy.
+   *
+   * @param local true for local replacement: a process replaces its own
+   * frames while it has any
+   * @param io the cost of paging a page in and a dirty page out
+   */
+  MMU(RAM& ram, ProcessTable& processes,
+      const TLB::Config& tlb = TLB::Config(), bool local = false,
+      const IOCost& io = IOCost());
+
+  /**
+   * Translate an access to page at time now, loading the page on a fault.
+   *
+   * The frame's timestamp and the page's referenced bit (and dirty bit, for
+   * a write) are updated, the policy is told about the access and the
+   * statistics, including the I/O cost of a fault, are counted. On a fault
+   * the policy may first release frames (WS, PFF), which are written back
+   * if dirty. After a fault, or the first access to a prefetched page, the
+   * pages the prefetcher predicts are loaded (see RAM::prefetch), each at
+   * the I/O cost of a fault. A write to a shared page is a copy-on-write
+   * fault.
+   *
+   * @param page the page accessed
+   * @param now the event clock of the access
+   * @param write true for a WRITE, false for a READ
+   * @return the frame holding the page and whether it faulted
+   */
+  Translation access(PageNumber page, EventTime now, bool write);
+
+  /**
+   * Allow huge pages of 2^shift pages (see PageTable::hugePages): a fault in
+   * a region with no base pages present loads the whole region into an
+   * aligned run of frames if one can be had, and the TLB caches it in one
+   * entry. The I/O cost of a huge page is that of all its pages.
+   *
+   * @return false if the page table layout has no level for that size
+   */
+  bool hugePages(unsigned shift);
+
+  /**
+   * @return every process's page tables
+   */
+  const ProcessTable& processes() const { return _processes; }
+
+  /**
+   * Clear the referenced bit of every PTE of every process (the CLEAR
+   * command).
+   */
+  void clearReferenced();
+
+  /**
+   * Context switch to process pid (the PROCESS command), creating its page
+   * table if it is new.
+   */
+  void switchTo(ProcessId pid);
+
+  /**
+   * Process pid exits (the FREE command): its frames go back to the free
+   * pool without writing back its dirty pages (but for those a forked
+   * process still maps), its TLB entries are dropped and so is its page
+   * table. If it is the running process it keeps
+   * running, with a new, empty address space.
+   *
+   * @return the number of frames freed
+   */
+  size_t free(ProcessId pid);
+
+  /**
+   * The running process forks process pid (the FORK command), which gets a
+   * copy-on-write share of the running process's address space. A process
+   * pid that already exists is freed first; forking the running process
+   * itself does nothing.
+   */
+  void fork(ProcessId pid);
+
+  /**
+   * @return the memory the processes use now: their pages against the
+   * frames holding them (counted only after a FORK) and their page tables
+   */
+  MemoryUse memoryUse() const;
+
+  /**
+   * @return the running process
+   */
+  ProcessId process() const { return _process; }
+
+  /**
+   * @return the active replacement policy
+   */
+  ReplacementPolicy& policy() { return *_policy; }
+
+  /**
+   * Make newPolicy the active replacement policy.
+   */
+  void policy(std::unique_ptr<ReplacementPolicy> newPolicy);
+
+  /**
+   * Load pages ahead of demand as newPrefetcher predicts them; nullptr for
+   * no prefetching (the default).
+   */
+  void prefetcher(std::unique_ptr<Prefetcher> newPrefetcher) {
+    _prefetcher = std::move(newPrefetcher);
+  }
+
+  /**
+   * @return the counts for the whole run so far
+   */
+  const Statistics& statistics() const { return _statistics; }
+
+  /**
+   * @return every policy used so far with the counts while it was active,
+   * the active one last
+   */
+  std::vector<PolicyPeriod> policyPeriods() const;
+
+  TLB& tlb() { return _tlb; }
+  RAM& ram() { return _ram; }
+
+  /**
+   * @return the running process's page table
+   */
+  PageTable& pageTable() { return *_pageTable; }
+
+  /**
+   * Save the whole translation state to a snapshot: the page tables, RAM,
+   * the running process, the TLB, the statistics and policy periods, and
+   * the active policy and prefetcher.
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * Replace the translation state with one saved to a snapshot, by a run
+   * with the same settings (RAM, page table layout, TLB, replacement scope,
+   * I/O cost and prefetcher).
+   *
+   * @throw std::runtime_error if the snapshot is bad, was taken with other
+   * settings or its policy cannot run here (OPT without its index)
+   */
+  void restore(SnapshotReader& in);
+
+ private:
+  /**
+   * Fill in the end totals and the policy's own counters for the period of
+   * the active policy.
+   */
+  void closePeriod(PolicyPeriod& period) const;
+
+  /**
+   * Give back the frames the policy releases before a fault of the running
+   * process at time now.
+   */
+  void release(EventTime now);
+
+  /**
+   * Account for the page the last load into RAM evicted, if it did: drop it
+   * from the TLB and count the eviction and its write-back.
+   */
+  void evicted();
+
+  /**
+   * Copy the tables on the path to page the running process shares, if any
+   * (see PageTable::unshare()), and drop its TLB entries, which point into
+   * the originals.
+   */
+  void unshare(PageNumber page);
+
+  /**
+   * A write to page, mapped by pte: if other PTE map its frame, unmap the
+   * page from pte so it faults into a frame of its own.
+   *
+   * @return true if so (a copy-on-write fault)
+   */
+  bool copyOnWrite(PageNumber page, PTE& pte);
+
+  /**
+   * Load the pages the prefetcher predicts after a fault on page (or, if
+   * hit, the first access to it since it was prefetched) at time now.
+   */
+  void prefetch(PageNumber page, EventTime now, bool hit);
+
+  RAM& _ram;
+  ProcessTable& _processes;
+  ProcessId _process{0};
+  PageTable* _pageTable;
+  bool _local;
+  IOCost _io;
+  std::unique_ptr<ReplacementPolicy> _policy;
+  std::unique_ptr<Prefetcher> _prefetcher;
+  TLB _tlb;
+  Statistics _statistics;
+  std::vector<PolicyPeriod> _periods;  // the last is the active policy
+  std::vector<FrameNumber> _released;  // scratch for release()
+  std::vector<PTE*> _copies;           // scratch for unshare()
+  std::vector<PageNumber> _predicted;  // scratch for prefetch()
+};
+
+#endif /* MMU_H */
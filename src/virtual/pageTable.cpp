@@ -1,31 +1,364 @@
 #include "pageTable.h"
 
-PageTable::PageTable(const size_t n) { resize(n); }
+#include <stdexcept>
+
+#include "snapshot.h"
+
+PageTable::PageTable(const size_t n)
+    : _width{n}, _shift{0}, _mask{~PageNumber(0)}, _size(n) {
+  _root = makeNode(0);
+}
+
+PageTable::PageTable(const std::vector<unsigned>& levelBits)
+    : _width(levelBits.size()),
+      _shift(levelBits.size()),
+      _mask(levelBits.size()) {
+  unsigned total = 0;
+  for (size_t d = levelBits.size(); d-- > 0;) {
+    _width[d] = size_t(1) << levelBits[d];
+    _shift[d] = total;
+    _mask[d] = _width[d] - 1;
+    total += levelBits[d];
+  }
+  _size = PageNumber(1) << total;
+  _root = makeNode(0);
+}
+
+std::unique_ptr<PageTable> PageTable::make(const std::string& layout,
+                                           const Geometry& geometry,
+                                           size_t n) {
+  unsigned bitsPerLevel;
+  if (layout == "flat")
+    return std::make_unique<PageTable>(n);
+  else if (layout == "x86")
+    bitsPerLevel = 10;
+  else if (layout == "x86-64")
+    bitsPerLevel = 9;
+  else
+    return nullptr;
+
+  std::vector<unsigned> levelBits;
+  for (unsigned bits = geometry.pageWidth(); bits > 0;) {
+    unsigned level = (bits % bitsPerLevel) ? bits % bitsPerLevel : bitsPerLevel;
+    levelBits.push_back(level);
+    bits -= level;
+  }
+  return std::make_unique<PageTable>(levelBits);
+}
+
+PageTable::PageTable(const PageTable& parent)
+    : _width(parent._width),
+      _shift(parent._shift),
+      _mask(parent._mask),
+      _size(parent._size),
+      _hugeDepth(parent._hugeDepth),
+      _hugeSize(parent._hugeSize),
+      _tables(parent._tables),
+      _bytes(parent._bytes),
+      _forked(true),
+      _root(share(parent._root.get())) {}
+
+void PageTable::Release::operator()(Node* node) const {
+  if (--node->users == 0) delete node;
+}
+
+PageTable::NodePtr PageTable::share(Node* node) {
+  node->users++;
+  return NodePtr(node);
+}
+
+PageTable::NodePtr PageTable::makeNode(unsigned depth) {
+  NodePtr node(new Node());
+  if (depth + 1 == levels())
+    node->entry.resize(_width[depth]);
+  else
+    node->child.resize(_width[depth]);
+  _bytes += nodeBytes(*node);
+  _tables++;
+  return node;
+}
+
+size_t PageTable::nodeBytes(const Node& node) {
+  return node.entry.size() * sizeof(PTE) +
+         node.child.size() * sizeof(NodePtr) +
+         node.large.size() * sizeof(PTE);
+}
+
+void PageTable::checkRange(PageNumber p) const {
+  if (p >= _size) throw std::out_of_range("PageTable: page out of range");
+}
+
+PTE& PageTable::operator[](PageNumber p) {
+  checkRange(p);
+  Node* node = _root.get();
+  unsigned d = 0;
+  for (; d + 1 < levels(); d++) {
+    auto& next = node->child[index(d, p)];
+    if (!next) next = makeNode(d + 1);
+    node = next.get();
+  }
+  return node->entry[index(d, p)];
+}
+
+const PTE* PageTable::find(PageNumber p) const {
+  checkRange(p);
+  const Node* node = _root.get();
+  unsigned d = 0;
+  for (; d + 1 < levels(); d++) {
+    if (d == _hugeDepth && !node->large.empty() &&
+        node->large[index(d, p)].present())
+      return &node->large[index(d, p)];
+    node = node->child[index(d, p)].get();
+    if (node == nullptr) return nullptr;
+  }
+  return &node->entry[index(d, p)];
+}
+
+PTE* PageTable::at(PageNumber p, bool large) {
+  checkRange(p);
+  Node* node = _root.get();
+  unsigned d = 0;
+  for (; d + 1 < levels(); d++) {
+    if (large && d == _hugeDepth)
+      return node->large.empty() ? nullptr : &node->large[index(d, p)];
+    node = node->child[index(d, p)].get();
+    if (node == nullptr) return nullptr;
+  }
+  return large ? nullptr : &node->entry[index(d, p)];
+}
+
+std::unique_ptr<PageTable> PageTable::fork() {
+  _forked = true;
+  return std::unique_ptr<PageTable>(new PageTable(*this));
+}
+
+size_t PageTable::unshare(PageNumber p, std::vector<PTE*>& copies) {
+  checkRange(p);
+  size_t copied = 0;
+  NodePtr* holder = &_root;
+  for (unsigned d = 0; *holder; d++) {
+    const Node& original = **holder;
+    if (original.users > 1) {
+      // copying a table shares its children, so the rest of the path is
+      // copied too
+      NodePtr copy(new Node());
+      copy->entry = original.entry;
+      copy->large = original.large;
+      copy->child.reserve(original.child.size());
+      for (const NodePtr& c : original.child)
+        copy->child.push_back(c ? share(c.get()) : nullptr);
+      for (PTE& pte : copy->entry)
+        if (pte.present()) copies.push_back(&pte);
+      for (PTE& pte : copy->large)
+        if (pte.present()) copies.push_back(&pte);
+      *holder = std::move(copy);
+      copied++;
+    }
+    if (d + 1 == levels()) break;
+    holder = &(*holder)->child[index(d, p)];
+  }
+  return copied;
+}
+
+bool PageTable::hugePages(unsigned shift) {
+  for (unsigned d = 0; d + 1 < levels(); d++)
+    if (_shift[d] == shift) {
+      _hugeDepth = d;
+      _hugeSize = PageNumber(1) << shift;
+      return true;
+    }
+  return false;
+}
+
+bool PageTable::hugeEligible(PageNumber p) const {
+  if (_hugeSize == 0) return false;
+  checkRange(p);
+  const Node* node = _root.get();
+  for (unsigned d = 0; d <= _hugeDepth; d++) {
+    node = node->child[index(d, p)].get();
+    if (node == nullptr) return true;
+  }
+  // the tables below: any present base page keeps the region small
+  std::vector<const Node*> pending{node};
+  while (!pending.empty()) {
+    const Node* table = pending.back();
+    pending.pop_back();
+    for (const PTE& pte : table->entry)
+      if (pte.present()) return false;
+    for (const auto& c : table->child)
+      if (c) pending.push_back(c.get());
+  }
+  return true;
+}
+
+PTE& PageTable::huge(PageNumber p) {
+  checkRange(p);
+  Node* node = _root.get();
+  for (unsigned d = 0; d < _hugeDepth; d++) {
+    auto& next = node->child[index(d, p)];
+    if (!next) next = makeNode(d + 1);
+    node = next.get();
+  }
+  if (node->large.empty()) {
+    node->large.resize(_width[_hugeDepth]);
+    _bytes += _width[_hugeDepth] * sizeof(PTE);
+  }
+  return node->large[index(_hugeDepth, p)];
+}
+
+PTE& PageTable::translation(PageNumber p) {
+  // through find(), so a present page is never unshared or allocated
+  const PTE* pte = find(p);
+  if (pte != nullptr) return const_cast<PTE&>(*pte);
+  return (*this)[p];
+}
 
 void PageTable::clearReferenced() {
-  for (auto i : (*this)) i.referenced(false);
+  auto clear = [](Node& leaf) {
+    PTE::clearReferenced(leaf.entry.data(), leaf.entry.size());
+  };
+  forEachTable(*_root, 0, levels() - 1, clear);
+  if (_hugeSize == 0) return;
+  auto clearLarge = [](Node& table) {
+    PTE::clearReferenced(table.large.data(), table.large.size());
+  };
+  forEachTable(*_root, 0, _hugeDepth, clearLarge);
 }
 
 FrameNumber PageTable::lookup(PageNumber p) {
-  if ((*this).at(p).present()) return (*this)[p].frame();
-  return noSuchFrame;
+  const PTE* pte = find(p);
+  if (pte == nullptr || !pte->present()) return noSuchFrame;
+  if (pte->large()) return pte->frame() + (p & (_hugeSize - 1));
+  return pte->frame();
 }
 
 PageNumber PageTable::findUnreferenced() {
-  for (int i = 0; i < (int)(*this).size(); i++)
-    if (!(*this).at(i).referenced()) return i;
-  return noSuchFrame;
+  return findUnreferenced(*_root, 0, 0);
 }
 
-PageNumber PageTable::findByFrame(FrameNumber frame) {
-  for (int i = 0; i < (int)(*this).size(); i++)
-    if ((*this)[i].present() && (*this)[i].frame() == frame) return i;
+PageNumber PageTable::findUnreferenced(const Node& node, unsigned depth,
+                                       PageNumber base) const {
+  if (depth + 1 == levels()) {
+    size_t i = PTE::findUnreferenced(node.entry.data(), node.entry.size());
+    return (i == node.entry.size()) ? noSuchPage : base + i;
+  }
+  for (size_t i = 0; i < node.child.size(); i++) {
+    if (!node.child[i]) continue;
+    PageNumber found = findUnreferenced(
+        *node.child[i], depth + 1, base + (PageNumber(i) << _shift[depth]));
+    if (found != noSuchPage) return found;
+  }
   return noSuchPage;
 }
 
-std::ostream& operator<<(std::ostream& out, const PageTable& pageTable) {
-  for (int i = 0; i < (int)pageTable.size(); i++) {
-    out << "  " << std::hex << i << " " << pageTable[i] << "\n";
+size_t PageTable::bytes(std::unordered_set<const Node*>& counted) const {
+  size_t total = 0;
+  std::vector<const Node*> pending{_root.get()};
+  while (!pending.empty()) {
+    const Node* node = pending.back();
+    pending.pop_back();
+    if (!counted.insert(node).second) continue;
+    total += nodeBytes(*node);
+    for (const NodePtr& c : node->child)
+      if (c) pending.push_back(c.get());
+  }
+  return total;
+}
+
+// the depth of the record that ends a table's snapshot
+static const unsigned endOfTables = ~0u;
+
+void PageTable::save(SnapshotWriter& out, SavedTables& saved) const {
+  out.put(levels());
+  for (size_t width : _width) out.put(width);
+  out.put(_size);
+  out.put(_hugeSize);
+  out.put(_forked);
+  out.put(_tables);
+  out.put(_bytes);
+  save(out, saved, *_root, 0, 0);
+  out.put(endOfTables);
+}
+
+void PageTable::save(SnapshotWriter& out, SavedTables& saved,
+                     const Node& node, unsigned depth,
+                     PageNumber base) const {
+  out.put(depth);
+  out.put(base);
+  // a table saved before is saved as its id + 1; 0 for a new one
+  auto [id, added] = saved.try_emplace(&node, saved.size());
+  out.put(added ? 0 : id->second + 1);
+  if (!added) return;
+  out.putArray(node.entry);
+  out.putArray(node.large);
+  for (size_t i = 0; i < node.child.size(); i++)
+    if (node.child[i])
+      save(out, saved, *node.child[i], depth + 1,
+           base + (PageNumber(i) << _shift[depth]));
+}
+
+void PageTable::restore(SnapshotReader& in, RestoredTables& restored) {
+  in.expect(levels(), "page table layout");
+  for (size_t width : _width) in.expect(width, "page table layout");
+  in.expect(_size, "number of pages");
+  in.expect(_hugeSize, "huge page size");
+  bool forked = in.get();
+  size_t tables = in.get();
+  size_t bytes = in.get();
+  for (unsigned depth; (depth = in.get()) != endOfTables;) {
+    PageNumber base = in.get();
+    uint64_t id = in.get();
+    if (depth >= levels() || base >= _size || id > restored.size())
+      throw std::runtime_error("bad page table in snapshot");
+    if (id != 0) {
+      NodePtr node = share(restored[id - 1]);
+      if (depth == 0)
+        _root = std::move(node);
+      else
+        reach(depth - 1, base).child[index(depth - 1, base)] =
+            std::move(node);
+      continue;
+    }
+    std::span<const PTE> entry = in.getArray<PTE>();
+    std::span<const PTE> large = in.getArray<PTE>();
+    if ((!entry.empty() && entry.size() != _width[depth]) ||
+        (!large.empty() &&
+         (depth != _hugeDepth || large.size() != _width[depth])))
+      throw std::runtime_error("bad page table in snapshot");
+    Node& node = reach(depth, base);
+    if (!entry.empty()) node.entry.assign(entry.begin(), entry.end());
+    if (!large.empty()) node.large.assign(large.begin(), large.end());
+    restored.push_back(&node);
+  }
+  _forked = forked;
+  _tables = tables;
+  _bytes = bytes;
+}
+
+PageTable::Node& PageTable::reach(unsigned depth, PageNumber base) {
+  Node* node = _root.get();
+  for (unsigned d = 0; d < depth; d++) {
+    auto& next = node->child[index(d, base)];
+    if (!next) next = makeNode(d + 1);
+    node = next.get();
   }
+  return *node;
+}
+
+PageNumber PageTable::size() const { return _size; }
+
+unsigned PageTable::levels() const { return _width.size(); }
+
+size_t PageTable::tables() const { return _tables; }
+
+size_t PageTable::bytes() const { return _bytes; }
+
+std::ostream& operator<<(std::ostream& out, const PageTable& pageTable) {
+  pageTable.forEach([&out](PageNumber p, const PTE& pte) {
+    out << "  " << std::hex << p << " " << pte << "\n";
+  });
+  pageTable.forEachHuge([&out](PageNumber p, const PTE& pte) {
+    if (pte.used()) out << "  " << std::hex << p << " " << pte << " huge\n";
+  });
   return out;
-}
\ No newline at end of file
+}
@@ -1,32 +1,178 @@
 /**
- * PageTable class extends vector to implement a Page Table structure
+ * PageTable class implements a Page Table structure
  *
  * A Page Table 'caches' page => frame lookups, theoretically lowering the cost
  * for lookup. As such I have tried to keep the operations for these as simple
  * as possible
  *
+ * The table is either flat (one vector of PTE, the original layout) or a
+ * radix tree of tables like the x86 (2-level) and x86-64 (4-level) MMU walk.
+ * Radix tables are only allocated when a page under them is first touched,
+ * so a sparse trace costs memory proportional to the pages it uses rather
+ * than to the size of the address space.
+ *
+ * A radix table can also map huge pages: an entry of an upper level table
+ * (the one whose entries each cover the huge page size, e.g. the level above
+ * the leaves for 2M pages under x86-64) maps its whole region at once, as
+ * the PS bit does in hardware. Those entries are kept in a second array of
+ * the upper level table, allocated the first time a huge page is mapped
+ * there; a region mapped huge needs no leaf table.
+ *
+ * fork() gives a new process a table that shares every table of this one,
+ * copy-on-write, as fork(2) does: the tables are reference counted, and a
+ * change under a shared table first copies the tables on the path to the
+ * page (unshare()), so a fork costs O(1) and each table is copied only
+ * when some process changes a page under it.
  */
 #ifndef PAGETABLE_H
 #define PAGETABLE_H
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "pte.h"
 #include "virtualMemoryTypes.h"
 
+class SnapshotReader;
+class SnapshotWriter;
+
 /**
- * A vector of PTE representing the page table for a single process.
+ * The page table for a single process.
  *
- * Extends vector so that [] works for clients of the PageTable.
+ * operator[] works like it does for a vector, except that the tables along
+ * the path to the PTE are allocated if they do not yet exist.
  */
-class PageTable : public std::vector<PTE> {
+class PageTable {
  public:
+  // a table in the tree (opaque outside PageTable)
+  struct Node;
+
+  // the tables saved to one snapshot so far, each with its id, and those
+  // restored from one, by id: a table shared by several processes is saved
+  // once
+  using SavedTables = std::unordered_map<const Node*, uint64_t>;
+  using RestoredTables = std::vector<Node*>;
+
   /**
-   * Constructor takes the number of pages in the page table.
+   * Constructor takes the number of pages in the page table; builds a flat
+   * table.
    */
   PageTable(const size_t n);
 
+  /**
+   * Constructor for a radix table. levelBits lists the number of page
+   * number bits translated at each level, root first; {10, 10} is the x86
+   * 2-level layout, {9, 9, 9, 9} the x86-64 4-level layout.
+   */
+  PageTable(const std::vector<unsigned>& levelBits);
+
+  /**
+   * Build a page table from a layout name: "flat" (n pages), "x86" (10 bits
+   * per level) or "x86-64" (9 bits per level). Radix layouts split the page
+   * number of the geometry into as many levels as it takes, the root taking
+   * any remainder: 32-bit addresses with 4K pages give {10, 10} for x86,
+   * 48-bit addresses give {9, 9, 9, 9} for x86-64.
+   *
+   * @param layout the name of the layout
+   * @param geometry the page size and address width being translated
+   * @param n number of pages for the flat layout
+   * @return the new page table; nullptr if layout is not a known name
+   */
+  static std::unique_ptr<PageTable> make(const std::string& layout,
+                                         const Geometry& geometry, size_t n);
+
+  /**
+   * Get the PTE for page p, allocating tables on the path to it as needed.
+   * No table on the path may be shared (see unshare()).
+   *
+   * @throw std::out_of_range if p is beyond the address space
+   */
+  PTE& operator[](PageNumber p);
+
+  /**
+   * Get the PTE for page p without allocating; the huge page PTE if p's
+   * region is mapped huge.
+   *
+   * @return pointer to the PTE; nullptr if its table was never allocated
+   * @throw std::out_of_range if p is beyond the address space
+   */
+  const PTE* find(PageNumber p) const;
+
+  /**
+   * Get p's own PTE or (large) the huge page PTE of p's region, present or
+   * not, without allocating.
+   *
+   * @return pointer to the PTE; nullptr if its table was never allocated
+   * @throw std::out_of_range if p is beyond the address space
+   */
+  PTE* at(PageNumber p, bool large);
+
+  /**
+   * Make a page table for a child process that shares every table of this
+   * one until one of them unshares it. Both tables are forked() from then
+   * on.
+   */
+  std::unique_ptr<PageTable> fork();
+
+  /**
+   * @return true if the table has shared its tables with another (by fork()
+   * either way), so they may need unsharing before a change
+   */
+  bool forked() const { return _forked; }
+
+  /**
+   * Copy each shared table on the path to page p, root first, so the path
+   * is this table's own; the PTE of the copies are the same as the
+   * originals'. The frames the copied PTE map are now mapped by both.
+   *
+   * @param copies gets every present PTE of the copied tables
+   * @return the number of tables copied
+   * @throw std::out_of_range if p is beyond the address space
+   */
+  size_t unshare(PageNumber p, std::vector<PTE*>& copies);
+
+  /**
+   * Allow huge pages of 2^shift pages each.
+   *
+   * @return false if no upper level's entries cover 2^shift pages (a flat
+   * table has none); huge pages stay off
+   */
+  bool hugePages(unsigned shift);
+
+  /**
+   * @return pages in a huge page; 0 if huge pages are not allowed
+   */
+  PageNumber hugeSize() const { return _hugeSize; }
+
+  /**
+   * @return number of levels walked to translate a huge page
+   */
+  unsigned hugeLevels() const { return _hugeDepth + 1; }
+
+  /**
+   * Could p's region be mapped by a huge page now: huge pages are allowed
+   * and no page of the region is present as a base page.
+   */
+  bool hugeEligible(PageNumber p) const;
+
+  /**
+   * Get the huge page PTE for p's region, allocating tables on the path to
+   * it as needed. Huge pages must be allowed, and no table on the path may
+   * be shared.
+   */
+  PTE& huge(PageNumber p);
+
+  /**
+   * Get the PTE that translates p: the huge page PTE if p's region is
+   * mapped huge, else p's own PTE (allocating tables as operator[] does, if
+   * p's leaf table was never allocated).
+   */
+  PTE& translation(PageNumber p);
+
   /**
    * Clear the referenced bit in all PTE.
    */
@@ -36,8 +182,8 @@ class PageTable : public std::vector<PTE> {
    * Lookup the given page in the PageTable.
    *
    * @param p page number to translate to FrameNumber
-   * @return the FrameNumber where the page is loaded (if it is present)
-   * noSuchFrame otherwise
+   * @return the FrameNumber where the page is loaded (if it is present; the
+   * frame within the run of a huge page) noSuchFrame otherwise
    */
   FrameNumber lookup(PageNumber p);
 
@@ -50,12 +196,213 @@ class PageTable : public std::vector<PTE> {
   PageNumber findUnreferenced();
 
   /**
-   * Find the page number associated with the give frame.
+   * @return number of pages in the address space the table covers
+   */
+  PageNumber size() const;
+
+  /**
+   * @return number of levels walked to translate a page (1 for flat)
+   */
+  unsigned levels() const;
+
+  /**
+   * @return number of tables (radix nodes) allocated, counting the tables
+   * shared with other page tables
+   */
+  size_t tables() const;
+
+  /**
+   * @return bytes used by the allocated tables, counting the tables shared
+   * with other page tables
+   */
+  size_t bytes() const;
+
+  /**
+   * @param counted the tables already counted; gets those counted now
+   * @return bytes used by the allocated tables not in counted
+   */
+  size_t bytes(std::unordered_set<const Node*>& counted) const;
+
+  /**
+   * Save every allocated table to a snapshot, root first, each leaf's PTE
+   * as one array; a table in saved (shared with a page table saved before)
+   * is saved as its id alone.
+   */
+  void save(SnapshotWriter& out, SavedTables& saved) const;
+
+  /**
+   * Rebuild the tables saved to a snapshot, sharing those saved by id with
+   * the tables in restored. The table must be as made, with no pages
+   * touched, and have the same layout (and huge page size).
    *
-   * @return page number of present page referring to given frame;
-   * noSuchPage if there is no such page.
+   * @throw std::runtime_error if the layout differs or the snapshot is bad
+   */
+  void restore(SnapshotReader& in, RestoredTables& restored);
+
+  /**
+   * Call visit(page, pte) for every PTE in an allocated table, in page
+   * number order.
+   */
+  template <typename Visit>
+  void forEach(Visit visit) const {
+    forEach(*_root, 0, 0, visit);
+  }
+
+  /**
+   * Call visit(firstPage, pte) for every huge page PTE in an allocated
+   * table, in page number order.
+   */
+  template <typename Visit>
+  void forEachHuge(Visit visit) const {
+    if (_hugeSize != 0) forEachHuge(*_root, 0, 0, visit);
+  }
+
+  /**
+   * Call visit(page, pte) for every PTE (huge page PTE included, with the
+   * first page of the region) in a table no other page table shares.
    */
-  PageNumber findByFrame(FrameNumber frame);
+  template <typename Visit>
+  void forEachOwned(Visit visit) {
+    forEachOwned(*_root, 0, 0, visit);
+  }
+
+ private:
+  // Drops a reference to a table, deleting it with the last one.
+  struct Release {
+    void operator()(Node* node) const;
+  };
+  using NodePtr = std::unique_ptr<Node, Release>;
+
+ public:
+  // A table in the tree: interior tables hold children, leaf tables PTE.
+  // users counts the tables (or roots) that point at it.
+  struct Node {
+    std::vector<NodePtr> child;
+    std::vector<PTE> entry;
+    std::vector<PTE> large;  // huge page entries, at the huge page depth
+    unsigned users{1};
+  };
+
+ private:
+  /**
+   * A fork's table: the same layout and counts as parent, sharing its root.
+   */
+  PageTable(const PageTable& parent);
+
+  /**
+   * Allocate a table for the given depth in the tree.
+   */
+  NodePtr makeNode(unsigned depth);
+
+  /**
+   * Another reference to node.
+   */
+  static NodePtr share(Node* node);
+
+  /**
+   * Bytes allocated for node's arrays.
+   */
+  static size_t nodeBytes(const Node& node);
+
+  /**
+   * Save node and the tables under it; base is the first page it covers.
+   */
+  void save(SnapshotWriter& out, SavedTables& saved, const Node& node,
+            unsigned depth, PageNumber base) const;
+
+  /**
+   * Get the table at depth covering page base, allocating the tables on
+   * the path to it as needed.
+   */
+  Node& reach(unsigned depth, PageNumber base);
+
+  /**
+   * Throw std::out_of_range unless p is in the address space.
+   */
+  void checkRange(PageNumber p) const;
+
+  /**
+   * Lowest present, unreferenced page under node; noSuchPage if none.
+   */
+  PageNumber findUnreferenced(const Node& node, unsigned depth,
+                              PageNumber base) const;
+
+  /**
+   * Index of page p in a table at the given depth.
+   */
+  size_t index(unsigned depth, PageNumber p) const {
+    return (p >> _shift[depth]) & _mask[depth];
+  }
+
+  template <typename Visit>
+  void forEach(const Node& node, unsigned depth, PageNumber base,
+               Visit& visit) const {
+    if (depth + 1 == levels()) {
+      for (size_t i = 0; i < node.entry.size(); i++)
+        visit(base + i, node.entry[i]);
+      return;
+    }
+    for (size_t i = 0; i < node.child.size(); i++)
+      if (node.child[i])
+        forEach(*node.child[i], depth + 1,
+                base + (PageNumber(i) << _shift[depth]), visit);
+  }
+
+  template <typename Visit>
+  void forEachHuge(const Node& node, unsigned depth, PageNumber base,
+                   Visit& visit) const {
+    if (depth == _hugeDepth) {
+      for (size_t i = 0; i < node.large.size(); i++)
+        visit(base + (PageNumber(i) << _shift[depth]), node.large[i]);
+      return;
+    }
+    for (size_t i = 0; i < node.child.size(); i++)
+      if (node.child[i])
+        forEachHuge(*node.child[i], depth + 1,
+                    base + (PageNumber(i) << _shift[depth]), visit);
+  }
+
+  template <typename Visit>
+  void forEachOwned(Node& node, unsigned depth, PageNumber base,
+                    Visit& visit) {
+    if (node.users > 1) return;
+    for (size_t i = 0; i < node.entry.size(); i++)
+      visit(base + i, node.entry[i]);
+    for (size_t i = 0; i < node.large.size(); i++)
+      visit(base + (PageNumber(i) << _shift[depth]), node.large[i]);
+    for (size_t i = 0; i < node.child.size(); i++)
+      if (node.child[i])
+        forEachOwned(*node.child[i], depth + 1,
+                     base + (PageNumber(i) << _shift[depth]), visit);
+  }
+
+  /**
+   * Call visit(node) for every allocated table at the given depth.
+   */
+  template <typename Visit>
+  void forEachTable(Node& node, unsigned depth, unsigned target,
+                    Visit& visit) {
+    if (depth == target) {
+      visit(node);
+      return;
+    }
+    for (auto& c : node.child)
+      if (c) forEachTable(*c, depth + 1, target, visit);
+  }
+
+  // entries in a table at each depth, root first, and the shift and mask
+  // that extract its index from a page number; a flat table is one leaf
+  // whose mask keeps the whole (range checked) page number
+  std::vector<size_t> _width;
+  std::vector<unsigned> _shift;
+  std::vector<PageNumber> _mask;
+  PageNumber _size;
+  unsigned _hugeDepth{~0u};  // depth of the huge page entries, if allowed
+  PageNumber _hugeSize{0};
+  size_t _tables{0};
+  size_t _bytes{0};
+  bool _forked{false};
+  NodePtr _root;
 };
 
 /**
@@ -65,6 +412,12 @@ class PageTable : public std::vector<PTE> {
  *   # PTE
  *
  * Where # is the hex page number in a space-padded field width of 3.
+ * Only pages in allocated tables are listed; pages in tables that were never
+ * touched are not present. Huge page entries follow, as
+ *
+ *   # PTE huge
+ *
+ * where # is the first page of the region.
  * @param out the output stream where the page table is to be printed
  * @param pageTable the page table to print
  * @return out; the output stream for continued processing
@@ -0,0 +1,109 @@
+#include "processTable.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "snapshot.h"
+
+std::unique_ptr<ProcessTable> ProcessTable::make(const std::string& layout,
+                                                 const Geometry& geometry,
+                                                 size_t n) {
+  std::unique_ptr<PageTable> first = PageTable::make(layout, geometry, n);
+  if (!first) return nullptr;
+  std::unique_ptr<ProcessTable> processes(
+      new ProcessTable(layout, geometry, n));
+  processes->_tables[0] = std::move(first);
+  return processes;
+}
+
+PageTable& ProcessTable::operator[](ProcessId pid) {
+  std::unique_ptr<PageTable>& table = _tables[pid];
+  if (!table) {
+    table = PageTable::make(_layout, _geometry, _pages);
+    if (_hugeShift != 0) table->hugePages(_hugeShift);
+  }
+  return *table;
+}
+
+PageTable* ProcessTable::find(ProcessId pid) {
+  auto found = _tables.find(pid);
+  return found == _tables.end() ? nullptr : found->second.get();
+}
+
+const PageTable* ProcessTable::find(ProcessId pid) const {
+  auto found = _tables.find(pid);
+  return found == _tables.end() ? nullptr : found->second.get();
+}
+
+std::vector<ProcessId> ProcessTable::pids() const {
+  std::vector<ProcessId> pids;
+  for (const auto& process : _tables) pids.push_back(process.first);
+  std::sort(pids.begin(), pids.end());
+  return pids;
+}
+
+void ProcessTable::fork(ProcessId parent, ProcessId child) {
+  std::unique_ptr<PageTable> table = (*this)[parent].fork();
+  _tables[child] = std::move(table);
+}
+
+bool ProcessTable::hugePages(unsigned shift) {
+  for (auto& process : _tables)
+    if (!process.second->hugePages(shift)) return false;
+  _hugeShift = shift;
+  return true;
+}
+
+size_t ProcessTable::bytes() const {
+  std::unordered_set<const PageTable::Node*> counted;
+  size_t total = 0;
+  for (const auto& process : _tables)
+    total += process.second->bytes(counted);
+  return total;
+}
+
+size_t ProcessTable::privateBytes() const {
+  size_t total = 0;
+  for (const auto& process : _tables) total += process.second->bytes();
+  return total;
+}
+
+PageNumber ProcessTable::mappedPages() const {
+  PageNumber total = 0;
+  for (const auto& process : _tables) {
+    const PageTable& table = *process.second;
+    table.forEach([&total](PageNumber, const PTE& pte) {
+      if (pte.present()) total++;
+    });
+    table.forEachHuge([&total, &table](PageNumber, const PTE& pte) {
+      if (pte.present()) total += table.hugeSize();
+    });
+  }
+  return total;
+}
+
+void ProcessTable::clearReferenced() {
+  for (auto& process : _tables) process.second->clearReferenced();
+}
+
+void ProcessTable::save(SnapshotWriter& out) const {
+  std::vector<ProcessId> ids = pids();
+  PageTable::SavedTables saved;
+  out.put(_hugeShift);
+  out.put(ids.size());
+  for (ProcessId pid : ids) {
+    out.put(pid);
+    _tables.at(pid)->save(out, saved);
+  }
+}
+
+void ProcessTable::restore(SnapshotReader& in) {
+  in.expect(_hugeShift, "huge page size");
+  _tables.clear();
+  PageTable::RestoredTables restored;
+  for (uint64_t n = in.get(); n-- > 0;) {
+    ProcessId pid = in.get();
+    (*this)[pid].restore(in, restored);
+  }
+}
@@ -0,0 +1,131 @@
+/**
+ * ProcessTable class holds the PageTable of every process.
+ *
+ * All processes share one RAM but each has its own PageTable, built with the
+ * same layout the first time the process runs. Tables are held by pointer in
+ * a hash table, so switching processes is a lookup and a pointer swap however
+ * many processes there are. A FORK shares the parent's tables with the
+ * child (see PageTable::fork()); they are copied only as either changes.
+ */
+
+#ifndef PROCESSTABLE_H
+#define PROCESSTABLE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pageTable.h"
+#include "virtualMemoryTypes.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+class ProcessTable {
+ public:
+  /**
+   * Build a process table whose page tables have the given layout (see
+   * PageTable::make). Process 0 is created at once.
+   *
+   * @return the new process table; nullptr if layout is not a known name
+   */
+  static std::unique_ptr<ProcessTable> make(const std::string& layout,
+                                            const Geometry& geometry,
+                                            size_t n);
+
+  /**
+   * Get the page table of process pid, creating it if the process is new.
+   */
+  PageTable& operator[](ProcessId pid);
+
+  /**
+   * @return the page table of process pid; nullptr if it has not run
+   */
+  PageTable* find(ProcessId pid);
+  const PageTable* find(ProcessId pid) const;
+
+  /**
+   * @return true if process pid has run (and not exited since)
+   */
+  bool contains(ProcessId pid) const { return _tables.contains(pid); }
+
+  /**
+   * @return the id of every process, in order
+   */
+  std::vector<ProcessId> pids() const;
+
+  /**
+   * Give process child a page table sharing every table of parent's, as
+   * fork(2) does; child must not have one.
+   */
+  void fork(ProcessId parent, ProcessId child);
+
+  /**
+   * Drop the page table of process pid, e.g. when it exits; it gets a new,
+   * empty one if it runs again. Its pages must not be in RAM.
+   */
+  void erase(ProcessId pid) { _tables.erase(pid); }
+
+  /**
+   * @return number of processes that have run
+   */
+  size_t size() const { return _tables.size(); }
+
+  /**
+   * Clear the referenced bit in all PTE of every process.
+   */
+  void clearReferenced();
+
+  /**
+   * Allow huge pages of 2^shift pages in every process's table (see
+   * PageTable::hugePages).
+   *
+   * @return false if the layout has no level for that size
+   */
+  bool hugePages(unsigned shift);
+
+  /**
+   * @return bytes used by the allocated tables of every process, a table
+   * shared by several counted once
+   */
+  size_t bytes() const;
+
+  /**
+   * @return bytes the tables of every process would use if none were
+   * shared
+   */
+  size_t privateBytes() const;
+
+  /**
+   * @return pages present in the tables of every process, a page mapped by
+   * several counted for each (every page of a huge page counts)
+   */
+  PageNumber mappedPages() const;
+
+  /**
+   * Save every process's page table to a snapshot, by process id; a table
+   * shared by several is saved once.
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * Replace every page table with those saved to a snapshot.
+   *
+   * @throw std::runtime_error if the tables were saved with another layout
+   *        or the snapshot is bad
+   */
+  void restore(SnapshotReader& in);
+
+ private:
+  ProcessTable(const std::string& layout, const Geometry& geometry, size_t n)
+      : _layout(layout), _geometry(geometry), _pages(n) {}
+
+  std::string _layout;
+  Geometry _geometry;
+  size_t _pages;
+  unsigned _hugeShift{0};  // 0: no huge pages
+  std::unordered_map<ProcessId, std::unique_ptr<PageTable>> _tables;
+};
+
+#endif /* PROCESSTABLE_H */
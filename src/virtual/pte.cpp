@@ -2,29 +2,18 @@
 
 #include <iomanip>
 
-PTE::PTE() {
-  _present = false;
-  _referenced = false;
-  _frame = noSuchFrame;
+void PTE::clearReferenced(PTE* entries, size_t n) {
+  // one AND per word; the compiler vectorizes this loop
+  for (size_t i = 0; i < n; i++) entries[i]._bits &= ~referencedBit;
 }
 
-FrameNumber PTE::frame() const { return _frame; }
-
-FrameNumber PTE::frame(FrameNumber newFrameNumber) {
-  // Uncomment for optional implementation where present bit is managed by PTE
-  // set function
-  // if (newFrameNumber == noSuchFrame) _present = false;
-  return _frame = newFrameNumber;
+size_t PTE::findUnreferenced(const PTE* entries, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    if ((entries[i]._bits & (presentBit | referencedBit)) == presentBit)
+      return i;
+  return n;
 }
 
-bool PTE::present() const { return _present; }
-
-bool PTE::present(bool newPresent) { return _present = newPresent; }
-
-bool PTE::referenced() const { return _referenced; }
-
-bool PTE::referenced(bool newReferenced) { return _referenced = newReferenced; }
-
 std::ostream& operator<<(std::ostream& out, const PTE& pte) {
   out << " |" << pte.present() << "|" << pte.referenced() << "|" << std::hex
       << std::setw(5) << std::setfill('0') << pte.frame() << "|";
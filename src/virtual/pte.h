@@ -4,6 +4,18 @@
  * A PTE object stores a FrameNumber (index into RAM array) and booleans for if
  * it is currently in RAM and whether it has been 'referenced' recently
  *
+ * The whole entry is packed into one 32-bit word, laid out like a hardware
+ * PTE:
+ *
+ *   31  30  29  28  27  26 .. 20  19 ........ 0
+ *   P   R   D   U   L   (unused)  frame number
+ *
+ * where U (used) records that the page has been loaded at least once and L
+ * (large) marks an entry that maps a huge page: the frame number is the
+ * first of an aligned run of frames holding it.
+ *
+ * so a cache line holds 16 entries and sweeps over a table are word
+ * operations.
  */
 
 #ifndef PTE_H
@@ -63,12 +75,127 @@ class PTE {
    */
   bool referenced(bool newReferenced);
 
+  /**
+   * Has the page been written since it was loaded?
+   *
+   * @return true if PTE dirty "bit" is set.
+   */
+  bool dirty() const;
+
+  /**
+   * Set the dirty "bit" in the PTE
+   *
+   * @param newDirty new value of dirty bit
+   * @return value of dirty after it is set
+   */
+  bool dirty(bool newDirty);
+
+  /**
+   * Has the page ever been loaded?
+   *
+   * @return true if PTE used "bit" is set.
+   */
+  bool used() const;
+
+  /**
+   * Set the used "bit" in the PTE
+   *
+   * @param newUsed new value of used bit
+   * @return value of used after it is set
+   */
+  bool used(bool newUsed);
+
+  /**
+   * Does the PTE map a huge page?
+   *
+   * @return true if PTE large "bit" is set.
+   */
+  bool large() const;
+
+  /**
+   * Set the large "bit" in the PTE
+   *
+   * @param newLarge new value of large bit
+   * @return value of large after it is set
+   */
+  bool large(bool newLarge);
+
+  /**
+   * Clear the referenced bit in n consecutive PTE.
+   */
+  static void clearReferenced(PTE* entries, size_t n);
+
+  /**
+   * Find the first of n consecutive PTE that is present and unreferenced.
+   *
+   * @return its index; n if there is none
+   */
+  static size_t findUnreferenced(const PTE* entries, size_t n);
+
+  // bits of the packed word; the frame number matches frameMask
+  static constexpr unsigned int presentBit = 0x80000000;
+  static constexpr unsigned int referencedBit = 0x40000000;
+  static constexpr unsigned int dirtyBit = 0x20000000;
+  static constexpr unsigned int usedBit = 0x10000000;
+  static constexpr unsigned int largeBit = 0x08000000;
+  static constexpr unsigned int frameBits = frameMask >> offsetWidth;
+
  private:
-  bool _present{false};
-  bool _referenced{false};
-  FrameNumber _frame{noSuchFrame};
+  unsigned int _bits{noSuchFrame & frameBits};
 };
 
+static_assert(sizeof(PTE) == 4, "PTE must pack into one 32-bit word");
+
+// The accessors are on the path of every access; defined here so every
+// module can inline them.
+
+inline PTE::PTE() {}
+
+inline FrameNumber PTE::frame() const { return _bits & frameBits; }
+
+inline FrameNumber PTE::frame(FrameNumber newFrameNumber) {
+  // Uncomment for optional implementation where present bit is managed by PTE
+  // set function
+  // if (newFrameNumber == noSuchFrame) present(false);
+  _bits = (_bits & ~frameBits) | (newFrameNumber & frameBits);
+  return frame();
+}
+
+inline bool PTE::present() const { return _bits & presentBit; }
+
+inline bool PTE::present(bool newPresent) {
+  _bits = newPresent ? (_bits | presentBit) : (_bits & ~presentBit);
+  return newPresent;
+}
+
+inline bool PTE::referenced() const { return _bits & referencedBit; }
+
+inline bool PTE::referenced(bool newReferenced) {
+  _bits = newReferenced ? (_bits | referencedBit) : (_bits & ~referencedBit);
+  return newReferenced;
+}
+
+inline bool PTE::dirty() const { return _bits & dirtyBit; }
+
+inline bool PTE::dirty(bool newDirty) {
+  _bits = newDirty ? (_bits | dirtyBit) : (_bits & ~dirtyBit);
+  return newDirty;
+}
+
+inline bool PTE::used() const { return _bits & usedBit; }
+
+inline bool PTE::used(bool newUsed) {
+  _bits = newUsed ? (_bits | usedBit) : (_bits & ~usedBit);
+  return newUsed;
+}
+
+inline bool PTE::large() const { return _bits & largeBit; }
+
+inline bool PTE::large(bool newLarge) {
+  _bits = newLarge ? (_bits | largeBit) : (_bits & ~largeBit);
+  return newLarge;
+}
+
 /**
  * Output operator for one PTE
  *
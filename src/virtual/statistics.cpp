@@ -0,0 +1,155 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+Statistics Statistics::operator-(const Statistics& earlier) const {
+  Statistics d;
+  d.reads = reads - earlier.reads;
+  d.writes = writes - earlier.writes;
+  d.faults = faults - earlier.faults;
+  d.evictions = evictions - earlier.evictions;
+  d.writebacks = writebacks - earlier.writebacks;
+  d.pages = pages - earlier.pages;
+  d.ioCycles = ioCycles - earlier.ioCycles;
+  d.releases = releases - earlier.releases;
+  d.residentTime = residentTime - earlier.residentTime;
+  d.hugeLoads = hugeLoads - earlier.hugeLoads;
+  d.hugeFallbacks = hugeFallbacks - earlier.hugeFallbacks;
+  d.prefetches = prefetches - earlier.prefetches;
+  d.prefetchHits = prefetchHits - earlier.prefetchHits;
+  d.forks = forks - earlier.forks;
+  d.cowFaults = cowFaults - earlier.cowFaults;
+  d.tablesCopied = tablesCopied - earlier.tablesCopied;
+  return d;
+}
+
+Statistics Statistics::operator+(const Statistics& other) const {
+  Statistics s;
+  s.reads = reads + other.reads;
+  s.writes = writes + other.writes;
+  s.faults = faults + other.faults;
+  s.evictions = evictions + other.evictions;
+  s.writebacks = writebacks + other.writebacks;
+  s.pages = pages + other.pages;
+  s.ioCycles = ioCycles + other.ioCycles;
+  s.releases = releases + other.releases;
+  s.residentTime = residentTime + other.residentTime;
+  s.hugeLoads = hugeLoads + other.hugeLoads;
+  s.hugeFallbacks = hugeFallbacks + other.hugeFallbacks;
+  s.prefetches = prefetches + other.prefetches;
+  s.prefetchHits = prefetchHits + other.prefetchHits;
+  s.forks = forks + other.forks;
+  s.cowFaults = cowFaults + other.cowFaults;
+  s.tablesCopied = tablesCopied + other.tablesCopied;
+  return s;
+}
+
+bool IOCost::parse(const std::string& spec) {
+  std::stringstream fields(spec);
+  std::string in, out;
+  if (!std::getline(fields, in, ',') || !std::getline(fields, out, ','))
+    return false;
+  try {
+    pageInCycles = std::stoul(in);
+    pageOutCycles = std::stoul(out);
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * "N accesses, F faults (P%), V evictions, W write-backs"
+ */
+static std::ostream& printCounts(std::ostream& out, const Statistics& s) {
+  out << s.accesses() << " accesses, " << s.faults << " faults ("
+      << std::fixed << std::setprecision(2) << s.faultRate() << "%), "
+      << s.evictions << " evictions, " << s.writebacks << " write-backs";
+  out.unsetf(std::ios::floatfield);
+  return out;
+}
+
+std::ostream& printInterval(std::ostream& out, unsigned long events,
+                            const Statistics& interval) {
+  out << std::dec << "events " << events << ": ";
+  printCounts(out, interval) << ", " << std::fixed << std::setprecision(2)
+                             << interval.averageResident() << " resident\n";
+  out.unsetf(std::ios::floatfield);
+  return out;
+}
+
+std::ostream& printSummary(std::ostream& out, const Statistics& total,
+                           const std::vector<PolicyPeriod>& periods,
+                           const MemoryUse& memory) {
+  out << std::dec << "Summary---------\n";
+  out << "  accesses   " << total.accesses() << " (" << total.reads
+      << " reads, " << total.writes << " writes)\n";
+  out << "  faults     " << total.faults << " (" << std::fixed
+      << std::setprecision(2) << total.faultRate() << "%)\n";
+  out.unsetf(std::ios::floatfield);
+  out << "  evictions  " << total.evictions << " (" << total.writebacks
+      << " written back)\n";
+  out << "  pages      " << total.pages << " distinct\n";
+  out << "  io cycles  " << total.ioCycles << " (" << std::fixed
+      << std::setprecision(2)
+      << (total.accesses() ? double(total.ioCycles) / total.accesses() : 0.0)
+      << " per access)\n";
+  out << "  resident   " << total.averageResident()
+      << " frames on average (" << total.releases << " released)\n";
+  out.unsetf(std::ios::floatfield);
+  if (total.hugeLoads + total.hugeFallbacks != 0)
+    out << "  huge       " << total.hugeLoads << " loaded, "
+        << total.hugeFallbacks << " fell back to base pages\n";
+  if (total.prefetches != 0) {
+    out << "  prefetch   " << total.prefetches << " loaded, "
+        << total.prefetchHits << " used (" << std::fixed
+        << std::setprecision(2) << total.prefetchAccuracy() << "% accuracy, "
+        << total.prefetchCoverage() << "% coverage)\n";
+    out.unsetf(std::ios::floatfield);
+  }
+  if (total.forks != 0) {
+    out << "  fork       " << total.forks << " forks, " << total.cowFaults
+        << " copy-on-write faults, " << total.tablesCopied
+        << " tables copied\n";
+    out << "  shared     " << memory.mappedPages << " pages in "
+        << memory.frames << " frames ("
+        << memory.mappedPages - std::min(memory.mappedPages, memory.frames)
+        << " saved), "
+        << memory.privateTableBytes - memory.tableBytes
+        << " table bytes saved\n";
+  }
+  out << "  tables     " << memory.tableBytes << " bytes\n";
+  // add up the periods of each policy, in order of first use
+  std::vector<PolicyPeriod> byPolicy;
+  for (const PolicyPeriod& period : periods) {
+    auto same = [&period](const PolicyPeriod& p) {
+      return p.name == period.name;
+    };
+    auto found = std::find_if(byPolicy.begin(), byPolicy.end(), same);
+    if (found == byPolicy.end())
+      found = byPolicy.insert(byPolicy.end(), PolicyPeriod{period.name});
+    found->end = found->end + (period.end - period.start);
+    for (const PolicyCounter& c : period.counters) {
+      auto counter = std::find_if(
+          found->counters.begin(), found->counters.end(),
+          [&c](const PolicyCounter& f) { return f.first == c.first; });
+      if (counter == found->counters.end())
+        found->counters.push_back(c);
+      else
+        counter->second += c.second;
+    }
+  }
+  for (const PolicyPeriod& policy : byPolicy) {
+    if (policy.end.accesses() == 0) continue;
+    out << "  " << std::left << std::setw(10) << std::setfill(' ')
+        << policy.name << " ";
+    printCounts(out, policy.end) << "\n";
+    for (const PolicyCounter& c : policy.counters)
+      out << "    " << std::setw(16) << c.first << c.second << "\n";
+    out << std::right;
+  }
+  out << "----------------\n";
+  return out;
+}
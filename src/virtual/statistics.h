@@ -0,0 +1,186 @@
+/**
+ * Statistics counts what happened to the accesses of a run: reads, writes,
+ * page faults, evictions (and the write-backs of dirty pages among them),
+ * the number of distinct pages touched, the simulated I/O time under an
+ * IOCost model, and the resident set: frames released by the policy and the
+ * frames in use at each access, summed so that an interval's average is a
+ * difference like every other count. With huge pages it also counts the
+ * faults that loaded one and those that fell back to a base page because no
+ * run of frames was free (fragmentation). With a prefetcher it counts the
+ * pages loaded ahead of demand and those of them used before their eviction.
+ * With FORK it counts the forks, the copy-on-write faults and the page
+ * tables copied when a process first changed a shared one.
+ *
+ * The MMU bumps the counters on every access; nothing is formatted until a
+ * report is printed. Reports for part of a run (an interval, or the time one
+ * policy was active) are differences of two snapshots.
+ */
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Statistics {
+  unsigned long reads{0};
+  unsigned long writes{0};
+  unsigned long faults{0};
+  unsigned long evictions{0};
+  unsigned long writebacks{0};  // evictions of dirty pages
+  unsigned long pages{0};       // distinct pages touched
+  unsigned long ioCycles{0};    // simulated paging I/O time
+  unsigned long releases{0};    // frames given back by WS or PFF
+  unsigned long residentTime{0};  // frames in use, summed over accesses
+  unsigned long hugeLoads{0};      // faults that loaded a huge page
+  unsigned long hugeFallbacks{0};  // ... that could have, but found no run
+  unsigned long prefetches{0};     // pages loaded ahead of demand
+  unsigned long prefetchHits{0};   // ... and used before they were evicted
+  unsigned long forks{0};
+  unsigned long cowFaults{0};     // faults on writes to shared pages
+  unsigned long tablesCopied{0};  // shared page tables copied on a change
+
+  unsigned long accesses() const { return reads + writes; }
+
+  /**
+   * @return page faults as a percentage of accesses
+   */
+  double faultRate() const {
+    return accesses() ? 100.0 * faults / accesses() : 0.0;
+  }
+
+  /**
+   * @return the average number of frames in use per access
+   */
+  double averageResident() const {
+    return accesses() ? double(residentTime) / accesses() : 0.0;
+  }
+
+  /**
+   * @return prefetched pages used as a percentage of pages prefetched
+   */
+  double prefetchAccuracy() const {
+    return prefetches ? 100.0 * prefetchHits / prefetches : 0.0;
+  }
+
+  /**
+   * @return the faults prefetching saved as a percentage of those there
+   * would have been without it
+   */
+  double prefetchCoverage() const {
+    return prefetchHits ? 100.0 * prefetchHits / (prefetchHits + faults)
+                        : 0.0;
+  }
+
+  /**
+   * @return the counts between snapshot earlier and this one
+   */
+  Statistics operator-(const Statistics& earlier) const;
+
+  /**
+   * @return the counts of this and other added up
+   */
+  Statistics operator+(const Statistics& other) const;
+};
+
+/**
+ * The cost of paging I/O: reading a page in on a fault and writing a dirty
+ * page out when it is evicted.
+ */
+struct IOCost {
+  unsigned long pageInCycles{1000000};
+  unsigned long pageOutCycles{1000000};
+
+  /**
+   * Parse "pageInCycles,pageOutCycles".
+   *
+   * @return true if spec is well formed
+   */
+  bool parse(const std::string& spec);
+};
+
+/**
+ * The memory the processes use at one point of a run: the pages present in
+ * their tables against the frames holding them (counted only after a FORK,
+ * when processes may share frames), and the bytes of their page tables
+ * against what they would take if none were shared.
+ */
+struct MemoryUse {
+  unsigned long mappedPages{0};
+  unsigned long frames{0};
+  size_t tableBytes{0};
+  size_t privateTableBytes{0};
+};
+
+/**
+ * A named counter kept by a replacement policy itself, e.g. CLOCK's second
+ * chances.
+ */
+using PolicyCounter = std::pair<std::string, unsigned long>;
+
+/**
+ * The part of a run during which one replacement policy was active.
+ */
+struct PolicyPeriod {
+  std::string name;
+  Statistics start;  // totals when the policy was selected
+  Statistics end;    // totals when it was replaced (or now)
+  std::vector<PolicyCounter> counters;  // the policy's own, at the end
+};
+
+/**
+ * Print one interval report line:
+ *
+ *   events E: N accesses, F faults (R%), V evictions, W write-backs,
+ *   A.AA resident
+ *
+ * (on one line), where A.AA is the average number of frames in use.
+ *
+ * @param out target output stream to print on
+ * @param events the event clock at the end of the interval
+ * @param interval the counts for the interval
+ * @return out for continued processing of the output stream
+ */
+std::ostream& printInterval(std::ostream& out, unsigned long events,
+                            const Statistics& interval);
+
+/**
+ * Print the end of run summary.
+ *
+ * Format:
+ * Summary---------
+ *   accesses   N (R reads, W writes)
+ *   faults     F (P%)
+ *   evictions  V (W written back)
+ *   pages      D distinct
+ *   io cycles  C (A per access)
+ *   resident   A.AA frames on average (L released)
+ *   huge       H loaded, B fell back to base pages
+ *   prefetch   P loaded, U used (A% accuracy, C% coverage)
+ *   fork       K forks, C copy-on-write faults, T tables copied
+ *   shared     M pages in U frames (S saved), B table bytes saved
+ *   tables     T bytes
+ *   NAME       N accesses, F faults (P%), V evictions, W write-backs
+ *     counter    value
+ * ----------------
+ *
+ * the huge line only if huge pages were loaded or fell back, the prefetch
+ * line only if pages were prefetched, the fork and shared lines only if
+ * processes forked; with one NAME
+ * line for each policy that saw accesses, in order of first
+ * use, adding up every period it was active; each is followed by the
+ * policy's own counters, also added up.
+ *
+ * @param out target output stream to print on
+ * @param total the counts for the whole run
+ * @param periods the policies used, in order
+ * @param memory the memory the processes use at the end
+ * @return out for continued processing of the output stream
+ */
+std::ostream& printSummary(std::ostream& out, const Statistics& total,
+                           const std::vector<PolicyPeriod>& periods,
+                           const MemoryUse& memory);
+
+#endif /* STATISTICS_H */
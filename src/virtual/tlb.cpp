@@ -0,0 +1,220 @@
+#include "tlb.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include "processTable.h"
+#include "snapshot.h"
+
+bool TLBConfig::parse(const std::string& spec) {
+  std::stringstream fields(spec);
+  std::string field;
+  try {
+    if (!std::getline(fields, field, ',')) return false;
+    entries = std::stoul(field);
+    if (std::getline(fields, field, ',')) ways = std::stoul(field);
+    if (std::getline(fields, field, ',')) {
+      if (field == "lru")
+        replacement = TLBReplacement::LRU;
+      else if (field == "fifo")
+        replacement = TLBReplacement::FIFO;
+      else if (field == "random")
+        replacement = TLBReplacement::RANDOM;
+      else
+        return false;
+    }
+    if (std::getline(fields, field, ',')) {
+      if (field != "flush" && field != "asid") return false;
+      asid = (field == "asid");
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+  return !std::getline(fields, field, ',') &&
+         (ways == 0 || (ways <= entries && entries % ways == 0));
+}
+
+bool TLBConfig::parseLatency(const std::string& spec) {
+  std::stringstream fields(spec);
+  std::string hit, walk;
+  if (!std::getline(fields, hit, ',') || !std::getline(fields, walk, ','))
+    return false;
+  try {
+    hitCycles = std::stoul(hit);
+    walkCycles = std::stoul(walk);
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+TLB::TLB(const Config& config) : _config(config), _entry(config.entries) {
+  _ways = (config.ways == 0) ? config.entries : config.ways;
+  if (_ways != 0) _sets = config.entries / _ways;
+}
+
+TLB::Entry* TLB::find(PageNumber tag) {
+  Entry* way = set(tag);
+  for (size_t w = 0; w < _ways; w++)
+    if (way[w].page == tag && way[w].asid == _asid) return &way[w];
+  return nullptr;
+}
+
+PTE* TLB::lookup(PageNumber page) {
+  if (!enabled()) return nullptr;
+  Entry* entry = live(find(page));
+  if (entry == nullptr && _hugeShift != 0) {
+    entry = live(find(hugeKey(page)));
+    if (entry != nullptr) _hugeHits++;
+  }
+  if (entry == nullptr) return nullptr;
+  if (_config.replacement == TLBReplacement::LRU) entry->stamp = ++_clock;
+  _hits++;
+  _cycles += _config.hitCycles;
+  return entry->pte;
+}
+
+TLB::Entry* TLB::live(Entry* entry) {
+  if (entry == nullptr || entry->pte->present()) return entry;
+  *entry = Entry();
+  return nullptr;
+}
+
+void TLB::insert(PageNumber page, PTE* pte, unsigned levels) {
+  if (!enabled()) return;
+  _misses++;
+  _cycles += _config.hitCycles + levels * _config.walkCycles;
+
+  // use an empty way if there is one, else the replacement choice
+  PageNumber tag = pte->large() ? hugeKey(page) : page;
+  Entry* way = set(tag);
+  Entry* slot = nullptr;
+  for (size_t w = 0; w < _ways && slot == nullptr; w++)
+    if (way[w].pte == nullptr) slot = &way[w];
+  if (slot == nullptr) {
+    if (_config.replacement == TLBReplacement::RANDOM) {
+      _random ^= _random << 13;
+      _random ^= _random >> 7;
+      _random ^= _random << 17;
+      slot = &way[_random % _ways];
+    } else {
+      slot = &way[0];
+      for (size_t w = 1; w < _ways; w++)
+        if (way[w].stamp < slot->stamp) slot = &way[w];
+    }
+  }
+  *slot = Entry{tag, _asid, pte, ++_clock};
+}
+
+void TLB::drop(PageNumber tag, unsigned asid) {
+  Entry* way = set(tag);
+  for (size_t w = 0; w < _ways; w++)
+    if (way[w].page == tag && way[w].asid == asid) way[w] = Entry();
+}
+
+void TLB::invalidate(PageNumber page, unsigned asid) {
+  if (!enabled()) return;
+  drop(page, asid);
+  if (_hugeShift != 0) drop(hugeKey(page), asid);
+}
+
+PageNumber TLB::reach() const {
+  PageNumber pages = 0;
+  for (const Entry& e : _entry)
+    if (e.pte != nullptr) pages += (e.page & hugeTag) ? hugeSize() : 1;
+  return pages;
+}
+
+void TLB::forget(unsigned asid) {
+  for (auto& e : _entry)
+    if (e.pte != nullptr && e.asid == asid) e = Entry();
+}
+
+void TLB::flush() {
+  for (auto& e : _entry) e = Entry();
+}
+
+void TLB::referencesCleared() {
+  if (!_config.asid) flush();
+}
+
+void TLB::switchTo(unsigned asid) {
+  if (asid == _asid) return;
+  if (!_config.asid) flush();
+  _asid = asid;
+}
+
+void TLB::save(SnapshotWriter& out) const {
+  out.put(_config.entries);
+  out.put(_config.ways);
+  out.put(unsigned(_config.replacement));
+  out.put(_config.asid);
+  out.put(_config.hitCycles);
+  out.put(_config.walkCycles);
+  out.put(_hugeShift);
+  out.put(_asid);
+  out.put(_clock);
+  out.put(_random);
+  out.put(_hits);
+  out.put(_hugeHits);
+  out.put(_misses);
+  out.put(_cycles);
+  for (const Entry& e : _entry) {
+    out.put(e.pte != nullptr);
+    if (e.pte == nullptr) continue;
+    out.put(e.page);
+    out.put(e.asid);
+    out.put(e.stamp);
+  }
+}
+
+void TLB::restore(SnapshotReader& in, ProcessTable& processes) {
+  in.expect(_config.entries, "TLB");
+  in.expect(_config.ways, "TLB");
+  in.expect(unsigned(_config.replacement), "TLB");
+  in.expect(_config.asid, "TLB");
+  in.expect(_config.hitCycles, "TLB latency");
+  in.expect(_config.walkCycles, "TLB latency");
+  in.expect(_hugeShift, "huge page size");
+  _asid = in.get();
+  _clock = in.get();
+  _random = in.get();
+  _hits = in.get();
+  _hugeHits = in.get();
+  _misses = in.get();
+  _cycles = in.get();
+  for (Entry& e : _entry) {
+    e = Entry();
+    if (!in.get()) continue;
+    e.page = in.get();
+    e.asid = in.get();
+    e.stamp = in.get();
+    PageTable* table = processes.find(e.asid);
+    bool large = e.page & hugeTag;
+    if (table != nullptr && (!large || _hugeShift != 0))
+      e.pte = table->at(large ? (e.page & ~hugeTag) << _hugeShift : e.page,
+                        large);
+    if (e.pte == nullptr) throw std::runtime_error("bad TLB in snapshot");
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const TLB& tlb) {
+  unsigned long accesses = tlb.hits() + tlb.misses();
+  out << "TLB------------\n";
+  out << std::dec << "  entries  " << tlb.config().entries << "  ways  "
+      << (tlb.config().ways == 0 ? tlb.config().entries : tlb.config().ways)
+      << "\n";
+  out << "  hits     " << tlb.hits() << "\n";
+  out << "  misses   " << tlb.misses() << "\n";
+  out << "  hit rate " << std::fixed << std::setprecision(2)
+      << (accesses ? 100.0 * tlb.hits() / accesses : 0.0) << "%\n";
+  out << "  cycles   " << tlb.cycles() << " ("
+      << (accesses ? double(tlb.cycles()) / accesses : 0.0)
+      << " per access)\n";
+  if (tlb.hugeSize() != 0)
+    out << "  huge     " << tlb.hugeHits() << " hits; reach " << tlb.reach()
+        << " pages\n";
+  out << "----------------\n";
+  out.unsetf(std::ios::floatfield);
+  return out;
+}
@@ -0,0 +1,240 @@
+/**
+ * TLB class implements a software model of a translation lookaside buffer.
+ *
+ * The TLB caches page => PTE translations in front of the PageTable. A hit
+ * hands back the PTE directly, so hot pages skip the page table walk; a miss
+ * costs one walk of every level of the table. Entries are grouped in sets
+ * (entries / ways of them) and replaced within a set by LRU, FIFO or random
+ * choice. An entry count of 0 disables the TLB.
+ *
+ * In flush mode the whole TLB is invalidated on CLEAR (and on any other
+ * address space change); in asid mode entries are tagged with the address
+ * space id and survive. *
+ * With huge pages an entry caches either one base page or one whole huge
+ * page (tagged by its region), so a huge page entry extends the TLB's reach
+ * by the pages it covers; lookups try the base page tag, then the region.
+ */
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pte.h"
+#include "virtualMemoryTypes.h"
+
+class ProcessTable;
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * How a TLB picks the entry to replace within a set.
+ */
+enum class TLBReplacement { LRU, FIFO, RANDOM };
+
+/**
+ * The shape and cost of a TLB.
+ */
+struct TLBConfig {
+  size_t entries{0};
+  size_t ways{0};  // 0 means fully associative
+  TLBReplacement replacement{TLBReplacement::LRU};
+  bool asid{false};  // tag with address space id instead of flushing
+  unsigned long hitCycles{1};
+  unsigned long walkCycles{20};  // per page table level
+
+  /**
+   * Parse "entries[,ways[,lru|fifo|random[,flush|asid]]]".
+   *
+   * @return true if spec is well formed
+   */
+  bool parse(const std::string& spec);
+
+  /**
+   * Parse "hitCycles,walkCycles".
+   *
+   * @return true if spec is well formed
+   */
+  bool parseLatency(const std::string& spec);
+};
+
+class TLB {
+ public:
+  using Replacement = TLBReplacement;
+  using Config = TLBConfig;
+
+  TLB(const Config& config = Config());
+
+  /**
+   * Is there a TLB to look in?
+   */
+  bool enabled() const { return !_entry.empty(); }
+
+  /**
+   * Cache huge pages of 2^shift pages, as one entry each.
+   */
+  void hugePages(unsigned shift) { _hugeShift = shift; }
+
+  /**
+   * Look page up in the current address space. An entry whose PTE is no
+   * longer present (its frame was evicted through another process's PTE
+   * that shares it) is dropped and misses.
+   *
+   * @return the cached PTE on a hit; nullptr on a miss
+   */
+  PTE* lookup(PageNumber page);
+
+  /**
+   * Cache the translation of page after a miss; a huge page PTE (large)
+   * is cached for the page's whole region. levels is the depth of the page
+   * table walk the miss cost.
+   */
+  void insert(PageNumber page, PTE* pte, unsigned levels);
+
+  /**
+   * Drop the translation of page in address space asid, if cached, and
+   * that of the huge page holding it.
+   */
+  void invalidate(PageNumber page, unsigned asid);
+
+  /**
+   * Drop every translation of address space asid, e.g. when its page table
+   * is copied or dropped.
+   */
+  void forget(unsigned asid);
+
+  /**
+   * Drop every translation.
+   */
+  void flush();
+
+  /**
+   * The page table's referenced bits were cleared; flushes in flush mode.
+   */
+  void referencesCleared();
+
+  /**
+   * Make asid the current address space; flushes in flush mode.
+   */
+  void switchTo(unsigned asid);
+
+  /**
+   * @return current address space id
+   */
+  unsigned asid() const { return _asid; }
+
+  unsigned long hits() const { return _hits; }
+  unsigned long hugeHits() const { return _hugeHits; }
+  unsigned long misses() const { return _misses; }
+
+  /**
+   * @return simulated cycles spent translating so far
+   */
+  unsigned long cycles() const { return _cycles; }
+
+  /**
+   * @return the pages the cached translations cover: one per base page
+   * entry and a huge page's worth per huge page entry
+   */
+  PageNumber reach() const;
+
+  /**
+   * @return pages in a huge page; 0 if huge pages are not cached
+   */
+  PageNumber hugeSize() const {
+    return _hugeShift ? PageNumber(1) << _hugeShift : 0;
+  }
+
+  const Config& config() const { return _config; }
+
+  /**
+   * Save the entries, by page and address space, and the counters to a
+   * snapshot.
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * Restore the entries and counters saved to a snapshot, pointing each
+   * entry at its PTE in processes, which must already be restored.
+   *
+   * @throw std::runtime_error if the TLB was saved with another shape or
+   *        cost, or the snapshot is bad
+   */
+  void restore(SnapshotReader& in, ProcessTable& processes);
+
+ private:
+  struct Entry {
+    PageNumber page{noSuchPage};
+    unsigned asid{0};
+    PTE* pte{nullptr};
+    unsigned long stamp{0};
+  };
+
+  // tag bit of a huge page entry; page numbers never reach it
+  static constexpr PageNumber hugeTag = PageNumber(1) << 63;
+
+  /**
+   * @return the tag of the huge page holding page
+   */
+  PageNumber hugeKey(PageNumber page) const {
+    return (page >> _hugeShift) | hugeTag;
+  }
+
+  /**
+   * @return the first entry of the set tag maps to
+   */
+  Entry* set(PageNumber tag) { return &_entry[(tag % _sets) * _ways]; }
+
+  /**
+   * @return the entry for tag in the current address space; nullptr if none
+   */
+  Entry* find(PageNumber tag);
+
+  /**
+   * @return entry, unless its PTE is no longer present: then the entry is
+   * dropped and nullptr returned
+   */
+  Entry* live(Entry* entry);
+
+  /**
+   * Drop the entry for tag in address space asid, if cached.
+   */
+  void drop(PageNumber tag, unsigned asid);
+
+  Config _config;
+  std::vector<Entry> _entry;
+  size_t _sets{1};
+  size_t _ways{0};
+  unsigned _asid{0};
+  unsigned _hugeShift{0};  // 0: no huge pages
+  unsigned long _clock{0};
+  unsigned long _random{0x9E3779B97F4A7C15UL};
+  unsigned long _hits{0};
+  unsigned long _hugeHits{0};
+  unsigned long _misses{0};
+  unsigned long _cycles{0};
+};
+
+/**
+ * Output operator for TLB statistics
+ *
+ * Format:
+ * TLB------------
+ *   entries  E  ways  W
+ *   hits     H
+ *   misses   M
+ *   hit rate R%
+ *   cycles   C (A per access)
+ *   huge     H hits; reach P pages
+ * ----------------
+ *
+ * the huge line only when huge pages are cached.
+ * @param out target output stream to print on
+ * @param tlb the TLB to report on
+ * @return out for continued processing of the output stream
+ */
+std::ostream& operator<<(std::ostream& out, const TLB& tlb);
+
+#endif /* TLB_H */